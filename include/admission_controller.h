@@ -0,0 +1,44 @@
+#ifndef ADMISSION_CONTROLLER_H
+#define ADMISSION_CONTROLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Контроль допуска запросов: ограничивает число одновременно обслуживаемых
+// запросов и длину очереди перед пулом обработчиков. Лишние запросы сразу
+// отклоняются, чтобы перегрузка давала быстрые ошибки, а не рост задержки.
+class AdmissionController {
+public:
+    struct Settings {
+        int max_in_flight = 256;
+        int max_queue_depth = 128;
+        // Адаптивный режим: сбрасываем нагрузку, пока среднее ожидание в очереди выше цели
+        bool adaptive = false;
+        int queue_wait_target_ms = 100;
+    };
+
+    explicit AdmissionController(const Settings& settings) : settings_(settings) {}
+
+    // false - запрос нужно отклонить (503)
+    bool TryAdmit();
+    // Запрос вышел из очереди и начал выполняться
+    void OnStart(std::chrono::steady_clock::duration queue_wait);
+    // Запрос обработан
+    void OnFinish();
+
+    int InFlight() const { return in_flight_.load(std::memory_order_relaxed); }
+    int Queued() const { return queued_.load(std::memory_order_relaxed); }
+    uint64_t Rejected() const { return rejected_.load(std::memory_order_relaxed); }
+    double QueueWaitMs() const { return queue_wait_ewma_us_.load(std::memory_order_relaxed) / 1000.0; }
+
+private:
+    Settings settings_;
+    std::atomic<int> in_flight_{ 0 };
+    std::atomic<int> queued_{ 0 };
+    std::atomic<uint64_t> rejected_{ 0 };
+    // Экспоненциальное скользящее среднее ожидания в очереди, микросекунды
+    std::atomic<int64_t> queue_wait_ewma_us_{ 0 };
+};
+
+#endif // ADMISSION_CONTROLLER_H
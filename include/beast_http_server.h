@@ -3,19 +3,87 @@
 
 #include "config.h"
 #include "database.h"
+#include "html_template.h"
+#include "compression.h"
+#include "admission_controller.h"
+#include "metrics.h"
+#include "server_state.h"
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <atomic>
 #include <vector>
 #include <thread>
+#include <memory>
+#include <string_view>
+#include <optional>
+#include <map>
+#include <mutex>
 
 namespace beast = boost::beast;
 namespace http = beast::http;
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
 
-//     
+// Глобальный флаг для обработки сигналов
 extern std::atomic<bool> g_signal_received;
+// Запрошена перезагрузка состояния (SIGHUP или /admin/reload)
+extern std::atomic<bool> g_reload_requested;
+
+class BeastHttpServer;
+
+// HTTP-сессия: одно TCP-соединение, на котором последовательно обслуживаются
+// запросы (keep-alive). Конвейерные запросы остаются в buffer_ и читаются по порядку.
+class HttpSession : public std::enable_shared_from_this<HttpSession> {
+public:
+    HttpSession(tcp::socket&& socket, BeastHttpServer& server, const net::ip::address& address);
+    ~HttpSession();
+
+    void Run();
+
+private:
+    static constexpr std::size_t kReadChunkSize = 4096;
+
+    void DoRead();
+    void OnIdleRead(beast::error_code ec, std::size_t bytes_transferred);
+    void ReadHeader();
+    void OnReadHeader(beast::error_code ec, std::size_t bytes_transferred);
+    void OnRead(beast::error_code ec, std::size_t bytes_transferred);
+    void WriteResponse(http::response<http::string_body>&& response, bool keep_alive);
+    void OnWrite(bool keep_alive, beast::error_code ec, std::size_t bytes_transferred);
+    void DoClose();
+
+    // Пакетный поиск: строки NDJSON уходят chunked-ответом строго в порядке
+    // запросов пакета, по мере их готовности
+    struct BatchStream {
+        std::vector<std::optional<std::string>> lines;
+        size_t next_line = 0;
+        size_t pending = 0;
+        bool writing = false;
+        bool finished = false;
+        bool failed = false;
+        bool keep_alive = false;
+        std::string current;
+        http::response<http::empty_body> header;
+        std::optional<http::response_serializer<http::empty_body>> serializer;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    void StartBatch(bool keep_alive);
+    void BeginBatchStream(std::shared_ptr<BatchStream> batch);
+    void OnBatchLine(std::shared_ptr<BatchStream> batch, size_t index, std::string line);
+    void WriteBatch();
+    void OnBatchWrite(beast::error_code ec, std::size_t bytes_transferred);
+
+    beast::tcp_stream stream_;
+    beast::flat_buffer buffer_;
+    std::optional<http::request_parser<http::string_body>> parser_;
+    http::request<http::string_body> req_;
+    std::shared_ptr<http::response<http::string_body>> res_;
+    BeastHttpServer& server_;
+    net::ip::address address_;
+    int requests_served_ = 0;
+    std::shared_ptr<BatchStream> batch_;
+};
 
 class BeastHttpServer {
 public:
@@ -26,24 +94,134 @@ public:
     void Stop();
 
 private:
+    friend class HttpSession;
+
+    // Маршруты, по которым раздельно считаются запросы и задержки
+    enum class Route { Landing, Search, ApiSearch, ApiBatch, Metrics, Other };
+    static constexpr int kRouteCount = 6;
+
+    struct MetricIds {
+        Metrics::Id requests[kRouteCount];
+        Metrics::Id latency[kRouteCount];
+        Metrics::Id render_seconds;
+        Metrics::Id queue_wait_seconds;
+        Metrics::Id connections_total;
+        Metrics::Id open_connections;
+        Metrics::Id rejected_connections;
+        Metrics::Id rejected_requests;
+        Metrics::Id cache_hits;
+        Metrics::Id cache_misses;
+        Metrics::Id state_version;
+        Metrics::Id index_generation;
+        Metrics::Id partial_results;
+    };
+
+    void RegisterMetrics();
+
+    // Режим "поток на ядро": у каждого потока свой io_context и свой acceptor на общем
+    // порту (SO_REUSEPORT). Ядро ОС само распределяет соединения, сессия не покидает поток.
+    struct Reactor {
+        net::io_context ioc{ 1 };
+        tcp::acceptor acceptor{ ioc };
+        std::thread thread;
+    };
+
     void Run();
     void CreateWorkerThreads();
-    void Listen();
-    void HandleRequest(http::request<http::string_body>&& req, std::shared_ptr<tcp::socket> socket);
-    void SendResponse(std::shared_ptr<tcp::socket> socket, http::response<http::string_body>&& response);
+    bool StartReactors(const tcp::endpoint& endpoint);
+    void StateRefreshThread();
+    // false - снимок не обновлен, остался текущий
+    bool ReloadState(bool reload_config);
+    void Listen(tcp::acceptor& acceptor, net::io_context& ioc);
+    bool AcquireConnectionSlot(const net::ip::address& address);
+    void ReleaseConnectionSlot(const net::ip::address& address);
+    http::response<http::string_body> HandleRequest(http::request<http::string_body>&& req,
+        const net::ip::address& client);
+    http::response<http::string_body> HandleAdmin(const http::request<http::string_body>& req,
+        std::string_view path, const ServingState& state);
+    http::response<http::string_body> HandleDebugTraces(const http::request<http::string_body>& req,
+        std::string_view params);
+    http::response<http::string_body> MakeOverloadResponse(const http::request<http::string_body>& req);
+
+    http::response<http::string_body> HandleSearch(const http::request<http::string_body>& req,
+        const ServingState& state, std::string_view params, bool cacheable);
+    static int SearchBudgetMs(const ServingState& state, std::string_view params);
+    http::response<http::string_body> HandleApiSearch(const http::request<http::string_body>& req,
+        const ServingState& state, std::string_view params);
+
+    // Пакет запросов с термами, разрешенными в id один раз на весь пакет
+    struct BatchPlan {
+        std::vector<std::string> queries;
+        std::vector<std::vector<std::string>> words;
+        // Пусто, если в запросе нет слов или какое-то слово не встречается в индексе
+        std::vector<std::vector<int>> word_ids;
+        int limit = 0;
+        int budget_ms = 0;
+        std::atomic<size_t> next_query{ 0 };
+    };
+
+    static bool IsBatchRequest(const http::request<http::string_body>& req);
+    bool PrepareBatch(const http::request<http::string_body>& req, const ServingState& state,
+        BatchPlan& plan, http::response<http::string_body>& error);
+    std::string RunBatchQuery(const BatchPlan& plan, size_t index);
+
+    // Условные ответы: ETag зависит от слов запроса, его параметров и поколения индекса
+    static std::string MakeETag(const ServingState& state, std::string_view kind,
+        const std::vector<std::string>& terms, int limit, int offset, ContentEncoding encoding);
+    static bool ETagMatches(const http::request<http::string_body>& req, std::string_view etag);
+    http::response<http::string_body> MakeNotModified(const http::request<http::string_body>& req,
+        const ServingState& state, const std::string& etag);
+    static void SetCacheHeaders(http::response<http::string_body>& res, const ServingState& state,
+        const std::string& etag);
 
     std::vector<std::string> ParseSearchQuery(const std::string& query);
 
+    static std::string UrlDecode(std::string_view value);
+    static std::string GetParameter(std::string_view params, std::string_view name);
+    static int GetIntParameter(std::string_view params, std::string_view name, int default_value);
+    static void CompressResponse(const http::request<http::string_body>& req, const ServingState& state,
+        http::response<http::string_body>& res);
+    static ContentEncoding SelectEncoding(const http::request<http::string_body>& req, const ServingState& state);
+
+    static http::response<http::string_body> MakeResponse(http::status status, unsigned version,
+        const char* content_type, std::string&& body);
+
     std::string GenerateSearchPage(const std::string& query);
-    std::string GenerateResultsPage(const std::vector<SearchResult>& results, const std::string& query);
+    std::string GenerateResultsPage(const std::vector<SearchResult>& results, const std::string& query,
+        bool partial = false);
     std::string GenerateErrorPage(const std::string& message);
 
     Config& config_;
     Database& db_;
+    bool per_core_ = false;
+    AdmissionController admission_;
+    MetricIds metric_ids_{};
+
+    // Число открытых соединений по адресам клиентов (защита от slowloris)
+    std::map<net::ip::address, int> connections_per_ip_;
+    std::mutex connections_mutex_;
+    std::atomic<bool> stopped_{ false };
+
+    // Текущий снимок состояния; новый собирается в state_thread_ и подменяется целиком
+    ServingStateHolder state_;
+    std::thread state_thread_;
+
+    // Шаблоны страниц разбираются один раз при создании сервера
+    HtmlTemplate search_page_template_;
+    HtmlTemplate results_header_template_;
+    HtmlTemplate result_item_template_;
+    HtmlTemplate error_page_template_;
+
+    // Объявлены последними, чтобы уничтожаться первыми. Сессии, оставшиеся
+    // после Stop() в очередях пула и io_context, уничтожаются вместе с ними и
+    // в деструкторе обращаются к счетчикам соединений и метрикам выше.
+    // Пул уничтожается раньше реакторов и ioc_: его задачи держат их сокеты
     net::io_context ioc_;
     tcp::acceptor acceptor_;
     std::vector<std::thread> worker_threads_;
-    std::atomic<bool> stopped_{ false };
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    // Потоки ioc_ занимаются только вводом-выводом, запросы выполняются в этом пуле
+    net::thread_pool handler_pool_;
 };
 
 #endif // BEAST_HTTP_SERVER_H
\ No newline at end of file
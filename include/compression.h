@@ -0,0 +1,76 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <string>
+#include <string_view>
+#include <zlib.h>
+
+enum class ContentEncoding {
+    Identity = 0,
+    Gzip = 1,
+    Deflate = 2
+};
+
+// Выбор кодировки по заголовку Accept-Encoding (gzip предпочтительнее deflate, q=0 запрещает)
+ContentEncoding NegotiateEncoding(std::string_view accept_encoding);
+const char* EncodingName(ContentEncoding encoding);
+// Разбор заголовка Content-Encoding ответа; false для неподдерживаемой кодировки
+bool ParseContentEncoding(std::string_view content_encoding, ContentEncoding& encoding);
+
+// Обертка над z_stream для сжатия. Состояние zlib выделяется один раз
+// и сбрасывается через deflateReset между вызовами.
+class Compressor {
+public:
+    Compressor(ContentEncoding encoding, int level);
+    ~Compressor();
+
+    Compressor(const Compressor&) = delete;
+    Compressor& operator=(const Compressor&) = delete;
+
+    bool Compress(std::string_view input, std::string& output);
+
+    // Компрессор текущего потока для заданной кодировки и уровня
+    static Compressor& ForThread(ContentEncoding encoding, int level);
+
+private:
+    z_stream stream_{};
+    ContentEncoding encoding_;
+    int level_;
+    bool initialized_ = false;
+};
+
+// Потоковая распаковка тела ответа: куски подаются по мере чтения из сети.
+// Состояние zlib выделяется один раз и сбрасывается через inflateReset2,
+// так что один объект можно использовать для многих ответов подряд.
+// Распакованный размер ограничен: "бомба" из мегабайта нулей в несколько
+// гигабайт обрывается, как только превысит max_output.
+class Decompressor {
+public:
+    explicit Decompressor(size_t max_output);
+    ~Decompressor();
+
+    Decompressor(const Decompressor&) = delete;
+    Decompressor& operator=(const Decompressor&) = delete;
+
+    bool Reset(ContentEncoding encoding);
+    void SetMaxOutput(size_t max_output) { max_output_ = max_output; }
+
+    // Дописывает распакованный кусок в output. false - ошибка в данных или
+    // превышен предел (LimitExceeded), дальше поток не читается
+    bool Feed(std::string_view input, std::string& output);
+
+    // Поток сжатых данных дошел до конца
+    bool Finished() const { return finished_; }
+    bool LimitExceeded() const { return limit_exceeded_; }
+
+private:
+    z_stream stream_{};
+    ContentEncoding encoding_ = ContentEncoding::Identity;
+    size_t max_output_;
+    bool initialized_ = false;
+    bool started_ = false;
+    bool finished_ = false;
+    bool limit_exceeded_ = false;
+};
+
+#endif // COMPRESSION_H
\ No newline at end of file
@@ -9,6 +9,7 @@ public:
     Config() = default;
 
     bool Load(const std::string& filename);
+    const std::string& GetFileName() const { return filename_; }
 
     // Database settings
     std::string GetDatabaseHost() const { return db_host_; }
@@ -16,6 +17,7 @@ public:
     std::string GetDatabaseName() const { return db_name_; }
     std::string GetDatabaseUser() const { return db_user_; }
     std::string GetDatabasePassword() const { return db_password_; }
+    int GetDatabaseReadPoolSize() const { return db_read_pool_size_; }
 
     // Spider settings
     std::string GetStartUrl() const { return start_url_; }
@@ -24,20 +26,70 @@ public:
     int GetRequestTimeout() const { return request_timeout_; }
     std::string GetUserAgent() const { return user_agent_; }
     int GetDelayBetweenRequests() const { return delay_between_requests_; }
+    std::string GetMetricsFile() const { return metrics_file_; }
+    int GetMetricsDumpInterval() const { return metrics_dump_interval_; }
+    int GetMaxConcurrentFetches() const { return max_concurrent_fetches_; }
+    int GetFetchThreads() const { return fetch_threads_; }
+    int GetDnsTtl() const { return dns_ttl_; }
+    int GetDnsNegativeTtl() const { return dns_negative_ttl_; }
+    int GetPoolMaxIdlePerHost() const { return pool_max_idle_per_host_; }
+    int GetPoolIdleTimeout() const { return pool_idle_timeout_; }
+    bool GetRespectCrawlDelay() const { return respect_crawl_delay_; }
+    int GetMaxCrawlDelay() const { return max_crawl_delay_; }
+    int GetFrontierMemoryUrls() const { return frontier_memory_urls_; }
+    int GetFrontierSegmentUrls() const { return frontier_segment_urls_; }
+    std::string GetFrontierDir() const { return frontier_dir_; }
+    int GetSeenExpectedUrls() const { return seen_expected_urls_; }
+    bool GetSeenBloom() const { return seen_bloom_; }
+    std::string GetCheckpointFile() const { return checkpoint_file_; }
+    int GetCheckpointInterval() const { return checkpoint_interval_; }
+    bool GetConditionalRecrawl() const { return conditional_recrawl_; }
+    int GetMaxDecompressedSize() const { return max_decompressed_size_; }
+    int GetMaxPageSize() const { return max_page_size_; }
 
     // Server settings
     int GetServerPort() const { return server_port_; }
     int GetMaxResults() const { return max_results_; }
     std::string GetServerHost() const { return server_host_; }
     int GetServerThreads() const { return server_threads_; }
+    bool GetReusePort() const { return reuse_port_; }
+    bool GetPinThreads() const { return pin_threads_; }
+    int GetKeepAliveTimeout() const { return keep_alive_timeout_; }
+    int GetMaxKeepAliveRequests() const { return max_keep_alive_requests_; }
+    int GetApiMaxLimit() const { return api_max_limit_; }
+    bool GetCompressionEnabled() const { return compression_enabled_; }
+    int GetCompressionLevel() const { return compression_level_; }
+    int GetCompressionMinSize() const { return compression_min_size_; }
+    int GetMaxInFlight() const { return max_in_flight_; }
+    int GetMaxQueueDepth() const { return max_queue_depth_; }
+    bool GetAdaptiveShedding() const { return adaptive_shedding_; }
+    int GetQueueWaitTargetMs() const { return queue_wait_target_ms_; }
+    int GetRetryAfter() const { return retry_after_; }
+    int GetHeaderTimeout() const { return header_timeout_; }
+    int GetBodyTimeout() const { return body_timeout_; }
+    int GetWriteTimeout() const { return write_timeout_; }
+    int GetMaxHeaderSize() const { return max_header_size_; }
+    int GetMaxBodySize() const { return max_body_size_; }
+    int GetMaxConnectionsPerIp() const { return max_connections_per_ip_; }
+    int GetSlowQueryMs() const { return slow_query_ms_; }
+    int GetTraceBufferSize() const { return trace_buffer_size_; }
+    std::string GetSlowQueryLog() const { return slow_query_log_; }
+    std::string GetCacheControl() const { return cache_control_; }
+    int GetGenerationPollInterval() const { return generation_poll_interval_; }
+    int GetBatchMaxQueries() const { return batch_max_queries_; }
+    int GetBatchMaxBodySize() const { return batch_max_body_size_; }
+    int GetSearchTimeoutMs() const { return search_timeout_ms_; }
 
 private:
+    std::string filename_;
+
     // Database
     std::string db_host_ = "localhost";
     int db_port_ = 5432;
     std::string db_name_ = "search_engine";
     std::string db_user_ = "postgres";
     std::string db_password_ = "admin";
+    int db_read_pool_size_ = 4;
 
     // Spider
     std::string start_url_ = "https://example.com";
@@ -46,12 +98,59 @@ private:
     int request_timeout_ = 30;
     std::string user_agent_ = "SearchEngineBot/1.0";
     int delay_between_requests_ = 100;
+    std::string metrics_file_ = "spider_metrics.prom";
+    int metrics_dump_interval_ = 10;
+    int max_concurrent_fetches_ = 256;
+    int fetch_threads_ = 1;
+    int dns_ttl_ = 300;
+    int dns_negative_ttl_ = 30;
+    int pool_max_idle_per_host_ = 4;
+    int pool_idle_timeout_ = 30;
+    bool respect_crawl_delay_ = true;
+    int max_crawl_delay_ = 30;
+    int frontier_memory_urls_ = 100000;
+    int frontier_segment_urls_ = 65536;
+    std::string frontier_dir_ = "frontier";
+    int seen_expected_urls_ = 1000000;
+    bool seen_bloom_ = false;
+    std::string checkpoint_file_ = "spider.checkpoint";
+    int checkpoint_interval_ = 60;
+    bool conditional_recrawl_ = true;
+    int max_decompressed_size_ = 10 * 1024 * 1024;
+    int max_page_size_ = 8 * 1024 * 1024;
 
     // Server
     int server_port_ = 8080;
     int max_results_ = 10;
     std::string server_host_ = "0.0.0.0";
     int server_threads_ = 4;
+    bool reuse_port_ = false;
+    bool pin_threads_ = false;
+    int keep_alive_timeout_ = 15;
+    int max_keep_alive_requests_ = 100;
+    int api_max_limit_ = 100;
+    bool compression_enabled_ = true;
+    int compression_level_ = 6;
+    int compression_min_size_ = 1024;
+    int max_in_flight_ = 256;
+    int max_queue_depth_ = 128;
+    bool adaptive_shedding_ = false;
+    int queue_wait_target_ms_ = 100;
+    int retry_after_ = 1;
+    int header_timeout_ = 10;
+    int body_timeout_ = 30;
+    int write_timeout_ = 30;
+    int max_header_size_ = 8192;
+    int max_body_size_ = 65536;
+    int max_connections_per_ip_ = 32;
+    int slow_query_ms_ = 500;
+    int trace_buffer_size_ = 64;
+    std::string slow_query_log_;
+    std::string cache_control_ = "public, max-age=60";
+    int generation_poll_interval_ = 2;
+    int batch_max_queries_ = 1000;
+    int batch_max_body_size_ = 1048576;
+    int search_timeout_ms_ = 1000;
 };
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Пул простаивающих keep-alive соединений, ключ - "scheme://host:port".
+// Соединение возвращается в пул после полностью прочитанного ответа, если сервер
+// не просил закрыть его. Пул не потокобезопасен: им пользуется только поток,
+// выполняющий io_context клиента.
+template <class Stream>
+class ConnectionPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void SetLimits(size_t max_idle_per_host, std::chrono::seconds idle_timeout) {
+        max_idle_per_host_ = max_idle_per_host;
+        idle_timeout_ = idle_timeout;
+    }
+
+    // Самое свежее простаивающее соединение или nullptr
+    std::unique_ptr<Stream> Acquire(const std::string& key) {
+        EvictExpired();
+        auto it = idle_.find(key);
+        if (it == idle_.end()) {
+            return nullptr;
+        }
+
+        auto stream = std::move(it->second.back().stream);
+        it->second.pop_back();
+        if (it->second.empty()) {
+            idle_.erase(it);
+        }
+        return stream;
+    }
+
+    void Release(const std::string& key, std::unique_ptr<Stream> stream) {
+        if (max_idle_per_host_ == 0) {
+            return;
+        }
+        auto& connections = idle_[key];
+        // Сверх лимита закрываем самое старое: оно первым истекло бы по таймауту
+        if (connections.size() >= max_idle_per_host_) {
+            connections.pop_front();
+        }
+        connections.push_back({ std::move(stream), Clock::now() });
+    }
+
+    size_t IdleCount() const {
+        size_t count = 0;
+        for (const auto& entry : idle_) {
+            count += entry.second.size();
+        }
+        return count;
+    }
+
+private:
+    struct IdleConnection {
+        std::unique_ptr<Stream> stream;
+        Clock::time_point since;
+    };
+
+    // Проход по всем хостам не чаще раза в секунду
+    void EvictExpired() {
+        const auto now = Clock::now();
+        if (now < next_sweep_) {
+            return;
+        }
+        next_sweep_ = now + std::chrono::seconds(1);
+
+        for (auto it = idle_.begin(); it != idle_.end();) {
+            auto& connections = it->second;
+            while (!connections.empty() && now - connections.front().since > idle_timeout_) {
+                connections.pop_front();
+            }
+            it = connections.empty() ? idle_.erase(it) : std::next(it);
+        }
+    }
+
+    std::unordered_map<std::string, std::deque<IdleConnection>> idle_;
+    size_t max_idle_per_host_ = 4;
+    std::chrono::seconds idle_timeout_{ 30 };
+    Clock::time_point next_sweep_{};
+};
+
+#endif // CONNECTION_POOL_H
@@ -0,0 +1,40 @@
+#ifndef CRAWL_CHECKPOINT_H
+#define CRAWL_CHECKPOINT_H
+
+#include "frontier.h"
+#include "seen_set.h"
+#include <string>
+#include <vector>
+
+// Контрольная точка обхода: отпечатки посещенных URL, очередь и загрузки,
+// бывшие в работе. Файл пишется во временный path.tmp и переименовывается,
+// так что на диске всегда есть целая предыдущая точка. В конце файла -
+// контрольная сумма: поврежденный или недописанный файл не загружается.
+//
+// Формат: "SPCK", версия; отпечатки (u64, 0 - конец); задачи (varint глубина+1,
+// URL, ETag, Last-Modified - строки с varint длиной; 0 - конец);
+// "END1" и FNV-1a всего предыдущего (u64).
+class CrawlCheckpoint {
+public:
+    struct Summary {
+        size_t seen = 0;
+        size_t queued = 0;
+    };
+
+    // Вызывающий отвечает за то, чтобы seen, frontier и in_flight на время
+    // записи не менялись: иначе точка не будет согласованной
+    static bool Save(const std::string& path, const SeenSet& seen, Frontier& frontier,
+        const std::vector<UrlTask>& in_flight, Summary* summary = nullptr);
+
+    // Загружает path, а если его нет или он поврежден - path.tmp, оставшийся
+    // от записи, прерванной между удалением старой точки и переименованием
+    static bool Load(const std::string& path, SeenSet& seen, Frontier& frontier, Summary* summary = nullptr);
+
+    static void Remove(const std::string& path);
+
+private:
+    static bool Verify(const std::string& path);
+    static bool LoadFile(const std::string& path, SeenSet& seen, Frontier& frontier, Summary* summary);
+};
+
+#endif // CRAWL_CHECKPOINT_H
\ No newline at end of file
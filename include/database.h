@@ -6,6 +6,9 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <chrono>
 
 struct Document {
     int id;
@@ -18,6 +21,12 @@ struct Document {
     }
 };
 
+// HTTP validators of a stored document
+struct DocumentValidators {
+    std::string etag;
+    std::string last_modified;
+};
+
 struct SearchResult {
     std::string url;
     std::string title;
@@ -30,6 +39,36 @@ struct SearchResult {
     }
 };
 
+// Время этапов поиска (миллисекунды), заполняется по запросу вызывающего
+struct SearchTimings {
+    double retrieve_ms = 0.0;
+    double snippet_ms = 0.0;
+};
+
+// Ограничение времени поиска. По истечении срока поиск возвращает то, что успел
+// найти, и выставляет partial.
+struct SearchBudget {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    bool partial = false;
+
+    // Бюджет от текущего момента; ms <= 0 - без ограничения
+    static SearchBudget After(int ms) {
+        SearchBudget budget;
+        if (ms > 0) {
+            budget.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+        }
+        return budget;
+    }
+    bool Limited() const { return deadline != std::chrono::steady_clock::time_point::max(); }
+};
+
+// Сводка об индексе: размеры берутся из статистики pg_class, без полного сканирования
+struct IndexStats {
+    long long generation = -1;
+    long long documents = 0;
+    long long words = 0;
+};
+
 class Database {
 public:
     Database();
@@ -38,12 +77,22 @@ public:
     bool Connect(const std::string& host, int port, const std::string& dbname,
         const std::string& user, const std::string& password);
     void Disconnect();
+    // Extra connections used only by searches, so that they run in parallel
+    int OpenReadPool(int size);
     bool CreateTables();
 
     // Document operations
     int AddDocument(const std::string& url, const std::string& title, const std::string& content);
     bool DocumentExists(const std::string& url);
     bool UpdateDocument(const std::string& url, const std::string& title, const std::string& content);
+    // HTTP validators (ETag, Last-Modified) and outgoing links of the stored copy,
+    // used for conditional re-crawls. The lookup is batched per page and goes through
+    // a read connection, so with an open read pool it does not wait for writers.
+    // URLs without stored validators are absent from the result
+    std::unordered_map<std::string, DocumentValidators> GetDocumentValidators(const std::vector<std::string>& urls);
+    bool SetDocumentValidators(int document_id, const std::string& etag, const std::string& last_modified,
+        const std::vector<std::string>& links);
+    std::vector<std::string> GetDocumentLinks(const std::string& url);
     std::vector<Document> GetAllDocuments();
 
     // Word operations
@@ -56,8 +105,19 @@ public:
     void UpdateDocumentWords(int document_id, const std::map<std::string, int>& word_frequencies);
     void ClearDocumentWords(int document_id);
 
+    // Index generation: -1 if the index_state table is missing or unreadable
+    void BumpIndexGeneration();
+    long long GetIndexGeneration();
+    IndexStats GetIndexStats();
+
     // Search
-    std::vector<SearchResult> SearchDocuments(const std::vector<std::string>& search_words, int limit);
+    std::vector<SearchResult> SearchDocuments(const std::vector<std::string>& search_words, int limit,
+        int offset = 0, SearchTimings* timings = nullptr, SearchBudget* budget = nullptr);
+    // Batch search: word ids are resolved once for the whole batch
+    std::unordered_map<std::string, int> ResolveWordIds(const std::vector<std::string>& words);
+    std::vector<SearchResult> SearchDocumentsByIds(const std::vector<int>& word_ids,
+        const std::vector<std::string>& search_words, int limit, int offset = 0, SearchTimings* timings = nullptr,
+        SearchBudget* budget = nullptr);
 
     // Statistics
     void PrintStats();
@@ -66,11 +126,35 @@ public:
     int GetDocumentWordCount();
 
 private:
+    // Соединение для чтения на время одного поиска: из пула, если он открыт,
+    // иначе основное соединение под db_mutex_
+    class ReadConnection {
+    public:
+        explicit ReadConnection(Database& db);
+        ~ReadConnection();
+        pqxx::connection& Get() { return *conn_; }
+
+    private:
+        Database& db_;
+        pqxx::connection* conn_ = nullptr;
+        std::unique_lock<std::mutex> lock_;
+    };
+
+    std::vector<SearchResult> RunSearch(const std::vector<std::string>& search_words,
+        const std::vector<int>* word_ids, int limit, int offset, SearchTimings* timings, SearchBudget* budget);
+    pqxx::result RunFallbackSearch(pqxx::connection& connection, const std::vector<std::string>& search_words,
+        const std::vector<int>* word_ids, int limit, int offset);
     std::string GenerateSnippet(const std::string& content, const std::vector<std::string>& search_words);
 
     std::unique_ptr<pqxx::connection> conn_;
     std::mutex db_mutex_;
     bool connected_ = false;
+    std::string connection_string_;
+
+    std::vector<std::unique_ptr<pqxx::connection>> read_pool_;
+    std::vector<pqxx::connection*> idle_read_connections_;
+    std::mutex read_pool_mutex_;
+    std::condition_variable read_pool_cv_;
 };
 
 #endif // DATABASE_H
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <boost/asio.hpp>
+#include <boost/beast/core/error.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Общий для всех загрузчиков кэш DNS. Успешные ответы живут ttl, ошибки
+// (несуществующий хост и т.п.) - negative_ttl. Пока имя разрешается, остальные
+// запросы того же host:port не запускают свой resolve, а ждут этот же ответ.
+// getaddrinfo не сообщает TTL записей, поэтому сроки задаются настройками.
+// Сам resolve идет на собственном потоке кэша: остановка io_context загрузчика,
+// первым запросившего имя, не оставляет остальных ожидающих без ответа.
+class DnsCache {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Results = boost::asio::ip::tcp::resolver::results_type;
+    using Handler = std::function<void(boost::beast::error_code, Results)>;
+
+    struct Stats {
+        uint64_t hits = 0;              // ответ из кэша
+        uint64_t negative_hits = 0;     // закэшированная ошибка
+        uint64_t misses = 0;            // запущен настоящий resolve
+        uint64_t coalesced = 0;         // присоединились к уже идущему resolve
+    };
+
+    void SetTtl(std::chrono::seconds ttl, std::chrono::seconds negative_ttl);
+
+    DnsCache();
+    ~DnsCache();
+
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    // handler вызывается через executor вызывающего, никогда не внутри AsyncResolve
+    void AsyncResolve(const std::string& host, const std::string& port,
+        boost::asio::any_io_executor executor, Handler handler);
+
+    Stats GetStats() const;
+
+private:
+    static constexpr size_t kMaxEntries = 65536;
+
+    struct Waiter {
+        boost::asio::any_io_executor executor;
+        Handler handler;
+    };
+
+    struct Entry {
+        Results results;
+        boost::beast::error_code error;
+        Clock::time_point expires{};
+        bool pending = false;
+        std::vector<Waiter> waiters;
+    };
+
+    void OnResolved(const std::string& key, boost::beast::error_code ec, Results results);
+    void EvictExpired(Clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::chrono::seconds ttl_{ 300 };
+    std::chrono::seconds negative_ttl_{ 30 };
+
+    std::atomic<uint64_t> hits_{ 0 };
+    std::atomic<uint64_t> negative_hits_{ 0 };
+    std::atomic<uint64_t> misses_{ 0 };
+    std::atomic<uint64_t> coalesced_{ 0 };
+
+    // Объявлен последним и останавливается первым: завершения resolve
+    // обращаются к полям выше
+    boost::asio::thread_pool resolve_pool_{ 1 };
+};
+
+#endif // DNS_CACHE_H
@@ -0,0 +1,189 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// У всех полей есть инициализаторы, так что { url, depth } не оставляет
+// неинициализированных членов (и -Wmissing-field-initializers молчит)
+struct UrlTask {
+    std::string url{};
+    int depth = 0;
+    bool robots = false;    // служебная загрузка robots.txt хоста, а не страница
+    // Валидаторы проиндексированной копии для условного запроса
+    std::string etag{};
+    std::string last_modified{};
+};
+
+// Политика приоритетов очереди обхода: меньшее значение загружается раньше
+class FrontierPriority {
+public:
+    static constexpr int kMaxPriority = 255;
+
+    virtual ~FrontierPriority() = default;
+
+    // Приоритет URL в пределах 0..kMaxPriority
+    virtual int UrlPriority(const UrlTask& task) const = 0;
+    // Добавка к приоритету хоста, с которого уже загружено fetched страниц:
+    // не дает одному большому сайту занять все свободные загрузчики
+    virtual int HostPenalty(uint32_t fetched) const = 0;
+};
+
+// По умолчанию: сначала мелкие глубины, внутри глубины - "ценные" на вид URL
+// (короткий путь, без параметров, не файл), хосты со многими загрузками позже
+class DefaultFrontierPriority : public FrontierPriority {
+public:
+    int UrlPriority(const UrlTask& task) const override;
+    int HostPenalty(uint32_t fetched) const override;
+};
+
+// Очередь обхода с вежливостью по хостам. У каждого хоста своя очередь URL,
+// упорядоченная по приоритету, и момент, раньше которого к нему нельзя
+// обращаться. Хосты, ждущие задержки, лежат в куче по этому моменту, готовые -
+// в куче по приоритету лучшего URL с поправкой на число загрузок с хоста.
+// Одновременно к хосту идет не больше одного запроса, следующий разрешен
+// через delay после завершения предыдущего.
+//
+// В памяти держится не больше memory_urls URL. Остальные копятся в буфере
+// и пачками по segment_urls сбрасываются на диск в сегменты, отсортированные
+// по (приоритет, URL), с общими префиксами соседних URL. Когда в памяти
+// остается меньше половины лимита, лучшие URL из сегментов и буфера
+// подчитываются обратно слиянием.
+// Потокобезопасна.
+class Frontier {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::chrono::milliseconds default_delay{ 0 };
+        bool fetch_robots = true;       // перед первой страницей хоста загрузить его robots.txt
+        size_t memory_urls = 100000;
+        size_t segment_urls = 65536;
+        std::string spill_dir = "frontier";
+    };
+
+    explicit Frontier(Options options, std::unique_ptr<FrontierPriority> priority = nullptr);
+    ~Frontier();
+
+    void Push(UrlTask task);
+
+    // URL хоста, к которому уже можно обращаться; хост считается занятым до Complete.
+    // Если готовых хостов нет, возвращает false и в next_ready - ближайший момент
+    // готовности (time_point::max(), если ждать нечего).
+    bool TryPop(UrlTask& task, Clock::time_point& next_ready);
+
+    // Загрузка с хоста завершена: следующая разрешена через его задержку
+    void Complete(const std::string& host);
+    // Задержка хоста из Crawl-delay
+    void SetHostDelay(const std::string& host, std::chrono::milliseconds delay);
+
+    size_t Size() const;
+    bool Empty() const { return Size() == 0; }
+
+    // Обходит все URL страниц в очереди, включая вытесненные на диск
+    // (служебные загрузки robots.txt пропускаются). Очередь на это время заблокирована.
+    void ForEach(const std::function<void(const UrlTask&)>& visit);
+
+    struct Stats {
+        size_t memory_urls = 0;
+        size_t spilled_urls = 0;        // в буфере и на диске
+        size_t segments = 0;
+        size_t hosts = 0;               // хосты с URL в памяти или с загрузкой в работе
+        uint64_t segment_bytes = 0;
+    };
+    Stats GetStats() const;
+
+    // "host[:port]" из URL в нижнем регистре
+    static std::string HostOf(const std::string& url);
+    // Crawl-delay в секундах из группы robots.txt для user_agent (или для "*");
+    // отрицательное значение, если директивы нет
+    static double ParseCrawlDelay(const std::string& robots, const std::string& user_agent);
+
+private:
+    struct QueuedUrl {
+        UrlTask task;
+        int priority = 0;
+        uint64_t seq = 0;       // порядок добавления при равном приоритете
+    };
+    struct LaterUrl {
+        bool operator()(const QueuedUrl& a, const QueuedUrl& b) const {
+            return std::tie(a.priority, a.seq) > std::tie(b.priority, b.seq);
+        }
+    };
+
+    enum class HostStatus { Idle, Waiting, Runnable, Busy };
+
+    struct HostState {
+        std::priority_queue<QueuedUrl, std::vector<QueuedUrl>, LaterUrl> urls;
+        Clock::time_point next_allowed{};
+        std::chrono::milliseconds delay{ 0 };
+        uint32_t fetched = 0;
+        HostStatus status = HostStatus::Idle;
+    };
+
+    // Что помнится о хосте после удаления его опустевшего состояния:
+    // robots.txt повторно не загружается, задержка сохраняется.
+    // Ключ - хеш имени хоста, чтобы не хранить сами имена.
+    struct KnownHost {
+        uint32_t delay_ms = 0;
+        uint32_t fetched = 0;
+    };
+
+    struct SpilledUrl {
+        UrlTask task;
+        int priority = 0;
+    };
+
+    // Сегмент на диске читается последовательно; next - уже декодированная
+    // очередная запись
+    struct Segment {
+        std::string path;
+        std::ifstream file;
+        size_t remaining = 0;
+        uint64_t bytes = 0;
+        std::string prev_url;
+        SpilledUrl next;
+    };
+
+    using WaitingEntry = std::pair<Clock::time_point, std::string>;
+    using RunnableEntry = std::tuple<int, Clock::time_point, std::string>;
+
+    HostState& GetHost(const std::string& host, const std::string& url);
+    void AddToMemory(HostState& state, UrlTask task, int priority);
+    void Schedule(const std::string& host, HostState& state);
+    void PromoteReady(Clock::time_point now);
+    void SweepIdleHosts(Clock::time_point now);
+
+    void SpillBuffer();
+    void Refill();
+    bool ReadNext(Segment& segment);
+
+    mutable std::mutex mutex_;
+    Options options_;
+    std::unique_ptr<FrontierPriority> priority_;
+
+    std::unordered_map<std::string, HostState> hosts_;
+    std::unordered_map<uint64_t, KnownHost> known_hosts_;
+    std::priority_queue<WaitingEntry, std::vector<WaitingEntry>, std::greater<WaitingEntry>> waiting_;
+    std::priority_queue<RunnableEntry, std::vector<RunnableEntry>, std::greater<RunnableEntry>> runnable_;
+    uint64_t next_seq_ = 0;
+    size_t memory_size_ = 0;
+    Clock::time_point next_sweep_{};
+
+    std::vector<SpilledUrl> spill_;
+    std::vector<std::unique_ptr<Segment>> segments_;
+    size_t segment_size_ = 0;       // URL во всех сегментах
+    uint64_t next_segment_ = 0;
+};
+
+#endif // FRONTIER_H
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef HTML_TEMPLATE_H
+#define HTML_TEMPLATE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <initializer_list>
+
+// HTML-шаблон, разобранный один раз при старте сервера.
+// Статический текст хранится готовыми фрагментами, а вместо {{имя}}
+// при рендеринге подставляются HTML-экранированные значения.
+class HtmlTemplate {
+public:
+    explicit HtmlTemplate(std::string_view source);
+
+    // Значения передаются в порядке первого появления имён в шаблоне;
+    // одно имя может встречаться в шаблоне несколько раз
+    void Render(std::string& out, std::initializer_list<std::string_view> values) const;
+
+    size_t StaticSize() const { return static_size_; }
+    const std::vector<std::string>& SlotNames() const { return slot_names_; }
+
+    static void AppendEscaped(std::string& out, std::string_view value);
+
+private:
+    // fragments_[i] выводится перед подстановкой slots_[i]; последний фрагмент без подстановки
+    std::vector<std::string> fragments_;
+    std::vector<size_t> slots_;
+    std::vector<std::string> slot_names_;
+    size_t static_size_ = 0;
+};
+
+#endif // HTML_TEMPLATE_H
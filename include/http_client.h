@@ -1,7 +1,17 @@
 #ifndef HTTP_CLIENT_H
 #define HTTP_CLIENT_H
 
+#include "compression.h"
+#include "connection_pool.h"
+#include "dns_cache.h"
 #include <string>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/ssl.hpp>
@@ -13,30 +23,162 @@ namespace net = boost::asio;
 namespace ssl = boost::asio::ssl;
 using tcp = net::ip::tcp;
 
+// Ресурсы, общие для всех HttpClient краулера: SSL-контекст, кэш TLS-сессий и кэш DNS.
+// Потокобезопасен; каждый рабочий поток держит свой HttpClient со своим
+// io_context и пулом соединений, а этот объект у них один на всех.
+class HttpClientContext {
+public:
+    struct TlsStats {
+        uint64_t handshakes = 0;
+        uint64_t resumed = 0;       // из них по сохраненной сессии, без полного обмена ключами
+    };
+
+    HttpClientContext();
+    ~HttpClientContext();
+
+    HttpClientContext(const HttpClientContext&) = delete;
+    HttpClientContext& operator=(const HttpClientContext&) = delete;
+
+    ssl::context& GetSslContext() { return ssl_ctx_; }
+    DnsCache& GetDnsCache() { return dns_cache_; }
+
+    // Подставляет в соединение последнюю сессию этого хоста, если она есть
+    void PrepareTlsResumption(SSL* ssl, const std::string& host);
+    void RecordHandshake(SSL* ssl);
+    TlsStats GetTlsStats() const;
+
+private:
+    static constexpr size_t kMaxTlsSessions = 4096;
+
+    // OpenSSL вызывает при получении новой сессии (в TLS 1.3 - тикета после handshake)
+    static int OnNewSession(SSL* ssl, SSL_SESSION* session);
+    void StoreTlsSession(const std::string& host, SSL_SESSION* session);
+
+    ssl::context ssl_ctx_;
+    DnsCache dns_cache_;
+
+    // LRU-кэш сессий по имени хоста (SNI); сессии принадлежат кэшу
+    std::mutex tls_mutex_;
+    std::list<std::pair<std::string, SSL_SESSION*>> tls_sessions_;
+    std::unordered_map<std::string, std::list<std::pair<std::string, SSL_SESSION*>>::iterator> tls_session_index_;
+
+    std::atomic<uint64_t> tls_handshakes_{ 0 };
+    std::atomic<uint64_t> tls_resumed_{ 0 };
+};
+
+// Клиент одного рабочего потока: io_context и пул соединений принадлежат ему,
+// общие ресурсы берутся из HttpClientContext.
 class HttpClient {
 public:
     struct HttpResponse {
         int status_code = 0;
-        std::string content;
+        std::string content;            // уже распакованное тело
         std::string content_type;
+        size_t transfer_size = 0;       // тело в том виде, как пришло по сети
+        // Непустая, если тело не читалось: не HTML или больше предела
+        std::string skip_reason;
+        // Валидаторы ответа для следующего условного запроса
+        std::string etag;
+        std::string last_modified;
+    };
+
+    // Валидаторы сохраненной копии: если заданы, запрос условный и сервер
+    // может ответить 304 без тела
+    struct Validators {
+        std::string etag;
+        std::string last_modified;
+    };
+
+    struct RequestOptions {
+        Validators validators;
+        // Ответ 200 с другим Content-Type обрывается сразу после заголовков
+        bool html_only = false;
+    };
+
+    // Статистика пула keep-alive соединений
+    struct PoolStats {
+        uint64_t hits = 0;              // запросы по уже открытому соединению
+        uint64_t misses = 0;            // запросы, открывшие новое соединение
+        double setup_seconds = 0.0;     // resolve + connect + handshake новых соединений
+        // Оценка сэкономленного: на каждое попадание - средняя установка соединения с этим хостом
+        double saved_seconds = 0.0;
+
+        double HitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0; }
     };
 
+    // Вызывается ровно один раз по завершении загрузки, в том числе с ошибкой
+    using DownloadHandler = std::function<void(HttpResponse)>;
+
+    // Без общего контекста клиент создает собственный
     HttpClient();
+    explicit HttpClient(std::shared_ptr<HttpClientContext> context);
     ~HttpClient();
 
+    // Асинхронная загрузка: resolve, connect, handshake, write и read выполняются
+    // на GetIoContext() без блокировок, поэтому одновременно могут идти сотни загрузок.
+    // handler вызывается в потоке, который выполняет io_context.
+    void AsyncDownload(const std::string& url, DownloadHandler handler);
+    void AsyncDownload(const std::string& url, const RequestOptions& options, DownloadHandler handler);
+
+    // Синхронная обертка над AsyncDownload: сама выполняет io_context до завершения.
+    // Нельзя вызывать, пока io_context выполняется в другом потоке.
     HttpResponse DownloadPage(const std::string& url);
-    bool IsValidUrl(const std::string& url);
+    static bool IsValidUrl(const std::string& url);
+    // text/html или application/xhtml+xml
+    static bool IsHtml(const std::string& content_type);
+
+    net::io_context& GetIoContext() { return ioc_; }
+    HttpClientContext& GetContext() { return *context_; }
 
     void SetTimeout(int timeout) { timeout_ = timeout; }
     void SetUserAgent(const std::string& user_agent) { user_agent_ = user_agent; }
+    void SetPoolLimits(int max_idle_per_host, int idle_timeout);
+    // Предел распакованного тела gzip/deflate: ответ больше него считается ошибкой
+    void SetMaxDecompressedSize(size_t bytes) { max_decompressed_size_ = bytes; }
+    // Предел тела в том виде, как оно идет по сети: больший Content-Length
+    // отклоняется по заголовкам, а без него чтение обрывается на пределе
+    void SetMaxBodySize(size_t bytes) { max_body_size_ = bytes; }
+
+    // Можно вызывать из любого потока
+    PoolStats GetPoolStats() const;
 
 private:
+    using PlainStream = beast::tcp_stream;
+    using SslStream = beast::ssl_stream<beast::tcp_stream>;
+
+    // Одна загрузка; Stream - PlainStream или SslStream
+    template <class Stream>
+    class Fetch;
+
+    template <class Stream>
+    ConnectionPool<Stream>& PoolFor();
+    void RecordSetup(const std::string& key, double seconds);
+    void RecordReuse(const std::string& key);
+    // Распаковщики переиспользуются между загрузками; только в потоке io_context
+    std::unique_ptr<Decompressor> AcquireDecompressor(ContentEncoding encoding);
+    void ReleaseDecompressor(std::unique_ptr<Decompressor> decompressor);
+
     std::string ResolveUrl(const std::string& url, std::string& host, std::string& port, std::string& target);
 
+    // Контекст объявлен первым: незавершенные загрузки в ioc_ уничтожаются раньше него
+    std::shared_ptr<HttpClientContext> context_;
     net::io_context ioc_;
-    ssl::context ssl_ctx_;
     int timeout_ = 30;
     std::string user_agent_ = "SearchEngineBot/1.0";
+    size_t max_decompressed_size_ = 10 * 1024 * 1024;
+    size_t max_body_size_ = 8 * 1024 * 1024;
+
+    ConnectionPool<PlainStream> plain_pool_;
+    ConnectionPool<SslStream> ssl_pool_;
+    // Средняя длительность установки соединения по ключу пула
+    std::unordered_map<std::string, double> setup_seconds_;
+    std::vector<std::unique_ptr<Decompressor>> idle_decompressors_;
+
+    // Пишутся только в потоке io_context, читаются откуда угодно
+    std::atomic<uint64_t> pool_hits_{ 0 };
+    std::atomic<uint64_t> pool_misses_{ 0 };
+    std::atomic<uint64_t> setup_micros_{ 0 };
+    std::atomic<uint64_t> saved_micros_{ 0 };
 };
 
 #endif // HTTP_CLIENT_H
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <vector>
+
+// Потоковый JSON-писатель: дописывает токены прямо в переданный буфер,
+// экранируя строки на месте, без промежуточных потоков и DOM.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out) {}
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    void Key(std::string_view key);
+    void String(std::string_view value);
+    void Int(int64_t value);
+    void Double(double value, int precision = 3);
+    void Bool(bool value);
+    void Null();
+
+    // Пара "ключ: значение" для объектов
+    void Field(std::string_view key, std::string_view value) { Key(key); String(value); }
+    void Field(std::string_view key, const char* value) { Key(key); String(value); }
+    void Field(std::string_view key, int64_t value) { Key(key); Int(value); }
+    void Field(std::string_view key, int value) { Key(key); Int(value); }
+    void Field(std::string_view key, double value) { Key(key); Double(value); }
+    void Field(std::string_view key, bool value) { Key(key); Bool(value); }
+
+    static void AppendEscaped(std::string& out, std::string_view value);
+
+private:
+    void BeforeValue();
+
+    static constexpr int kMaxDepth = 32;
+
+    std::string& out_;
+    // Для каждого уровня вложенности: записан ли уже хотя бы один элемент
+    bool has_items_[kMaxDepth] = {};
+    int depth_ = 0;
+    bool after_key_ = false;
+};
+
+// Разбор JSON-массива строк (тело пакетного поиска). Возвращает false при
+// любой синтаксической ошибке или если элемент массива не строка.
+bool ParseJsonStringArray(std::string_view json, std::vector<std::string>& out);
+
+#endif // JSON_H
@@ -0,0 +1,51 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Гистограмма задержек в духе HdrHistogram: значения в микросекундах,
+// корзины логарифмически-линейные (2048 подкорзин на каждую степень двойки),
+// поэтому относительная погрешность любого перцентиля не больше 0.1%
+// во всем диапазоне от 1 мкс до ~2 часов. Запись без блокировок и аллокаций;
+// каждый поток пишет в свою гистограмму, в конце они объединяются через Merge.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void Record(uint64_t micros);
+    void Merge(const LatencyHistogram& other);
+
+    uint64_t Count() const { return total_count_; }
+    uint64_t Min() const { return total_count_ ? min_ : 0; }
+    uint64_t Max() const { return max_; }
+    double Mean() const;
+    double StdDev() const;
+
+    // Наименьшее значение, не меньше которого percentile% записей (0..100)
+    uint64_t ValueAtPercentile(double percentile) const;
+
+    // Полное распределение по перцентилям в формате HdrHistogram
+    // (Value, Percentile, TotalCount, 1/(1-Percentile)), значения в миллисекундах.
+    // Шаг перцентилей уменьшается вдвое на каждой половине оставшегося расстояния до 100%.
+    void PrintPercentileDistribution(std::ostream& out, int ticks_per_half_distance = 5) const;
+
+private:
+    static constexpr int kSubBucketBits = 11;
+    static constexpr uint64_t kSubBucketCount = 1ull << kSubBucketBits;
+    static constexpr uint64_t kSubBucketHalfCount = kSubBucketCount / 2;
+    static constexpr int kMaxShift = 32;
+    static constexpr uint64_t kMaxValue = (kSubBucketCount << kMaxShift) - 1;
+
+    static size_t IndexOf(uint64_t value);
+    static uint64_t LowestValueAt(size_t index);
+    static uint64_t HighestValueAt(size_t index);
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_H
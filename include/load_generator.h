@@ -0,0 +1,176 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include "latency_histogram.h"
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+struct BenchOptions {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    // Путь запроса; текст запроса добавляется как q=..., extra_params - после него
+    std::string target = "/api/search";
+    std::string extra_params;
+
+    int connections = 16;
+    int threads = 0;                // 0 - по числу ядер, но не больше connections
+    // Открытый цикл: запросов в секунду на все соединения. 0 - закрытый цикл
+    // (каждое соединение шлет следующий запрос сразу после ответа)
+    double rate = 0.0;
+    int duration_sec = 10;
+    int warmup_sec = 1;
+    uint64_t max_requests = 0;      // 0 - по времени; иначе столько запросов, включая прогрев
+    bool keep_alive = true;
+    int timeout_ms = 5000;
+
+    // Источник запросов: журнал (по строке на запрос) или словарь для распределения Ципфа
+    std::string query_log;
+    std::string vocabulary;
+    double zipf_exponent = 1.0;
+    int min_words = 1;
+    int max_words = 2;
+    uint64_t seed = 1;
+};
+
+// Выдает тексты запросов: по кругу из журнала или случайно из словаря.
+// Словарь упорядочен по убыванию частоты, слово ранга k выбирается
+// с вероятностью, пропорциональной 1 / k^s.
+class QuerySource {
+public:
+    bool LoadQueryLog(const std::string& filename);
+    bool LoadVocabulary(const std::string& filename, double exponent, int min_words, int max_words);
+
+    std::string Next(std::mt19937_64& rng);
+    size_t Size() const { return replay_ ? queries_.size() : vocabulary_.size(); }
+    bool IsReplay() const { return replay_; }
+
+private:
+    static bool ReadLines(const std::string& filename, std::vector<std::string>& lines);
+
+    bool replay_ = false;
+    std::vector<std::string> queries_;
+    std::atomic<size_t> next_query_{ 0 };
+
+    std::vector<std::string> vocabulary_;
+    std::vector<double> cumulative_;
+    int min_words_ = 1;
+    int max_words_ = 1;
+};
+
+// Итоги прогона. Каждый поток копит свои, в конце они складываются.
+struct BenchStats {
+    // Задержка от запланированного момента отправки: в открытом цикле учитывает
+    // ожидание свободного соединения (поправка на coordinated omission)
+    LatencyHistogram latency;
+    // Чистое время от отправки запроса до получения ответа
+    LatencyHistogram service_time;
+    uint64_t requests = 0;
+    uint64_t status_2xx = 0;
+    uint64_t status_3xx = 0;
+    uint64_t status_4xx = 0;
+    uint64_t status_5xx = 0;
+    uint64_t errors = 0;
+    uint64_t timeouts = 0;
+    uint64_t connects = 0;
+    uint64_t bytes = 0;
+
+    void Merge(const BenchStats& other);
+};
+
+class BenchConnection;
+
+// Генератор нагрузки: несколько io_context (по одному на поток),
+// между ними по кругу распределены соединения с сервером.
+class LoadGenerator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LoadGenerator(const BenchOptions& options, QuerySource& queries);
+
+    // Разрешает адрес и проверяет, что он локальный. Бенчмарк нельзя
+    // направить на чужой сервер.
+    bool Resolve(std::string& error);
+    // Блокирует до окончания прогона
+    void Run();
+
+    const BenchStats& Stats() const { return total_; }
+    double MeasuredSeconds() const { return measured_seconds_; }
+    void PrintReport(std::ostream& out) const;
+
+private:
+    friend class BenchConnection;
+
+    struct Worker {
+        net::io_context ioc{ 1 };
+        BenchStats stats;
+        Clock::time_point last_response{};
+        std::mt19937_64 rng;
+        std::vector<std::shared_ptr<BenchConnection>> connections;
+    };
+
+    // Резервирует запрос, запланированный на when; false - прогон закончен
+    bool AcquireRequest(Clock::time_point when);
+    std::string BuildTarget(Worker& worker);
+    bool Measuring(Clock::time_point now) const { return now >= measure_start_; }
+
+    const BenchOptions options_;
+    QuerySource& queries_;
+    tcp::resolver::results_type endpoints_;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<uint64_t> issued_{ 0 };
+    Clock::time_point start_;
+    Clock::time_point measure_start_;
+    Clock::time_point stop_;
+    Clock::duration interval_{};
+
+    BenchStats total_;
+    double measured_seconds_ = 0.0;
+};
+
+// Одно соединение с сервером. Запросы по нему идут строго последовательно:
+// в открытом цикле каждый по своему расписанию, в закрытом - друг за другом.
+class BenchConnection : public std::enable_shared_from_this<BenchConnection> {
+public:
+    BenchConnection(LoadGenerator& generator, LoadGenerator::Worker& worker,
+        LoadGenerator::Clock::time_point first_send);
+
+    void Start();
+
+private:
+    void ScheduleNext();
+    void Send();
+    void OnConnect(beast::error_code ec);
+    void Write();
+    void OnWrite(beast::error_code ec, std::size_t bytes_transferred);
+    void OnRead(beast::error_code ec, std::size_t bytes_transferred);
+    void Fail(beast::error_code ec);
+    void Close();
+
+    LoadGenerator& generator_;
+    LoadGenerator::Worker& worker_;
+    beast::tcp_stream stream_;
+    net::steady_timer timer_;
+    beast::flat_buffer buffer_;
+    http::request<http::empty_body> request_;
+    http::response<http::string_body> response_;
+    bool connected_ = false;
+
+    LoadGenerator::Clock::time_point intended_;
+    LoadGenerator::Clock::time_point sent_;
+};
+
+#endif // LOAD_GENERATOR_H
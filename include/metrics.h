@@ -0,0 +1,97 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Реестр метрик (счетчики, gauge, гистограммы) с выдачей в текстовом формате Prometheus.
+// Счетчики и гистограммы пишутся в шард текущего потока без блокировок:
+// у каждого шарда один писатель, поэтому хватает relaxed load/store.
+// При выдаче (/metrics или файл) шарды всех потоков суммируются.
+class Metrics {
+public:
+    using Id = uint32_t;
+
+    static Metrics& Instance();
+
+    // Регистрация выполняется при старте; повторная регистрация с тем же
+    // именем и метками возвращает уже существующий Id.
+    // labels задаются в виде "route=\"/search\""
+    Id RegisterCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Id RegisterGauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Id RegisterHistogram(const std::string& name, const std::string& help,
+        const std::vector<double>& bounds, const std::string& labels = "");
+
+    void Increment(Id counter, uint64_t delta = 1);
+    void AddGauge(Id gauge, int64_t delta);
+    void SetGauge(Id gauge, int64_t value);
+    void Observe(Id histogram, double value);
+
+    std::string Render() const;
+    bool DumpToFile(const std::string& filename) const;
+
+    // Границы корзин для задержек в секундах (от 100 мкс до 10 с)
+    static const std::vector<double>& LatencyBuckets();
+    // Границы корзин для размеров в байтах
+    static const std::vector<double>& SizeBuckets();
+
+    // Замеряет время жизни объекта и записывает его в гистограмму
+    class Timer {
+    public:
+        explicit Timer(Id histogram)
+            : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+        ~Timer() { Instance().Observe(histogram_, Seconds()); }
+
+        double Seconds() const {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+        }
+
+    private:
+        Id histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Metric {
+        Type type;
+        std::string name;
+        std::string help;
+        std::string labels;
+        std::vector<double> bounds;
+        // Первая ячейка метрики в шарде: корзины, затем count и sum (биты double)
+        size_t slot = 0;
+    };
+
+    // Шарды имеют фиксированный размер, чтобы запись никогда не требовала перевыделения
+    static constexpr size_t kMaxSlots = 4096;
+
+    struct Shard {
+        std::atomic<uint64_t> slots[kMaxSlots] = {};
+    };
+
+    Metrics();
+
+    Id Register(Type type, const std::string& name, const std::string& help,
+        const std::string& labels, const std::vector<double>& bounds);
+    Shard& LocalShard();
+    void RenderMetric(std::ostream& out, const Metric& metric) const;
+    uint64_t SumSlot(size_t slot) const;
+    double SumDoubleSlot(size_t slot) const;
+
+    mutable std::mutex mutex_;
+    std::vector<Metric> metrics_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    // Gauge хранятся глобально: их значение задается, а не накапливается
+    std::unique_ptr<std::atomic<int64_t>[]> gauges_{ new std::atomic<int64_t>[kMaxSlots]() };
+    size_t next_slot_ = 0;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,68 @@
+#ifndef SEEN_SET_H
+#define SEEN_SET_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Множество уже встреченных URL. Хранит не строки, а 64-битные отпечатки в
+// таблицах с открытой адресацией (линейное пробирование), разбитых на шарды
+// со своими мьютексами. Перед таблицей шарда может стоять блочный фильтр Блума:
+// все биты одного отпечатка лежат в одном 64-битном слове, так что ответ
+// "точно новый" стоит одного обращения к памяти и пробирование пропускается.
+//
+// Отпечатки могут совпасть у разных URL: на 100 млн URL вероятность хотя бы
+// одного ложного "уже видели" около 3e-4. Для краулера это приемлемо.
+// Потокобезопасно.
+class SeenSet {
+public:
+    explicit SeenSet(size_t expected_urls = 1 << 20, bool use_bloom = true, size_t shards = 64);
+
+    // Проверка и вставка одним шагом: true, если URL встречен впервые
+    bool Insert(const std::string& url) { return InsertFingerprint(Fingerprint(url)); }
+    bool Contains(const std::string& url) const { return ContainsFingerprint(Fingerprint(url)); }
+
+    bool InsertFingerprint(uint64_t fingerprint);
+    bool ContainsFingerprint(uint64_t fingerprint) const;
+
+    size_t Size() const;
+    // Обходит все отпечатки, блокируя шарды по одному
+    void ForEach(const std::function<void(uint64_t)>& visit) const;
+    // Память таблиц и фильтров
+    size_t MemoryBytes() const;
+
+    struct Stats {
+        uint64_t bloom_negatives = 0;   // вставки, где фильтр сразу сказал "новый"
+        uint64_t probes = 0;            // вставки с пробированием таблицы
+    };
+    Stats GetStats() const;
+
+    static uint64_t Fingerprint(const std::string& url);
+
+private:
+    static constexpr double kMaxLoad = 0.7;
+    static constexpr int kBloomBitsPerUrl = 10;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::vector<uint64_t> slots;    // 0 - пустой слот
+        size_t count = 0;
+        std::vector<uint64_t> bloom;
+        uint64_t bloom_negatives = 0;
+        uint64_t probes = 0;
+    };
+
+    Shard& ShardFor(uint64_t fingerprint) const;
+    static bool BloomTestAndSet(Shard& shard, uint64_t fingerprint);
+    static bool TableInsert(Shard& shard, uint64_t fingerprint);
+    static void Grow(Shard& shard);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    uint64_t shard_mask_ = 0;
+    bool use_bloom_;
+};
+
+#endif // SEEN_SET_H
\ No newline at end of file
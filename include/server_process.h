@@ -0,0 +1,38 @@
+#ifndef SERVER_PROCESS_H
+#define SERVER_PROCESS_H
+
+#include <map>
+#include <string>
+
+// Экземпляр search_server, запущенный бенчмарком. Сервер читает config.ini из
+// текущего каталога, поэтому у каждого запуска свой рабочий каталог с копией
+// конфигурации, в которой подменены нужные ключи. Вывод сервера пишется
+// в server.log там же.
+class ServerProcess {
+public:
+    ServerProcess() = default;
+    ~ServerProcess();
+
+    ServerProcess(const ServerProcess&) = delete;
+    ServerProcess& operator=(const ServerProcess&) = delete;
+
+    // Копирует base_config в work_dir/config.ini, заменяя ключи секции section
+    // (недостающие дописываются в ее конец)
+    static bool WriteConfig(const std::string& base_config, const std::string& work_dir,
+        const std::string& section, const std::map<std::string, std::string>& overrides, std::string& error);
+
+    bool Start(const std::string& executable, const std::string& work_dir, std::string& error);
+    // Процесс запущен и еще не завершился
+    bool Running();
+    // Просит завершиться, а не успевший за несколько секунд процесс убивает
+    void Stop();
+
+private:
+#ifdef _WIN32
+    void* process_ = nullptr;   // HANDLE
+#else
+    int pid_ = -1;
+#endif
+};
+
+#endif // SERVER_PROCESS_H
@@ -0,0 +1,49 @@
+#ifndef SERVER_STATE_H
+#define SERVER_STATE_H
+
+#include "config.h"
+#include "database.h"
+#include <boost/beast/http.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Неизменяемый снимок всего, чем обслуживаются запросы: параметры выдачи из
+// конфигурации, сведения об индексе и готовые ответы. Запрос берет снимок в начале
+// и работает с ним до конца, перезагрузка публикует новый снимок целиком.
+struct ServingState {
+    uint64_t version = 0;
+    std::chrono::system_clock::time_point loaded_at;
+
+    // Индекс: поколение (-1 - неизвестно, ETag не выдаются) и оценки размеров
+    IndexStats index;
+
+    // Параметры, которые можно менять без перезапуска
+    int max_results = 10;
+    int api_max_limit = 100;
+    bool compression_enabled = true;
+    int compression_level = 6;
+    int compression_min_size = 1024;
+    std::string cache_control;
+    // Бюджет времени одного поиска, 0 - без ограничения
+    int search_timeout_ms = 0;
+
+    // Стартовая страница для каждой ContentEncoding
+    boost::beast::http::response<boost::beast::http::string_body> landing_responses[3];
+
+    void ApplyConfig(const Config& config);
+};
+
+// Точка публикации снимков в стиле RCU: читатели получают shared_ptr без блокировок
+// обработки, старый снимок живет, пока его держит хотя бы один запрос.
+class ServingStateHolder {
+public:
+    std::shared_ptr<const ServingState> Load() const;
+    void Store(std::shared_ptr<const ServingState> state);
+
+private:
+    std::shared_ptr<const ServingState> state_;
+};
+
+#endif // SERVER_STATE_H
@@ -2,21 +2,28 @@
 #define THREADED_SPIDER_H
 
 #include "config.h"
+#include "crawl_checkpoint.h"
 #include "database.h"
+#include "frontier.h"
 #include "http_client.h"
 #include "html_parser.h"
+#include "metrics.h"
+#include "seen_set.h"
 #include <string>
 #include <queue>
-#include <unordered_set>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 #include <condition_variable>
 #include <atomic>
 
-struct UrlTask {
-    std::string url;
-    int depth;
+// Загруженная страница, ожидающая разбора
+struct FetchedPage {
+    UrlTask task;
+    HttpClient::HttpResponse response;
+    size_t fetcher = 0;     // загрузчик, которому вернуть освободившееся место
 };
 
 class ThreadedSpider {
@@ -31,28 +38,103 @@ public:
     int GetErrorCount() const { return error_count_; }
 
 private:
+    void FetchThread(size_t index);
+    void DispatchFetches(size_t index);
+    void WakeFetcher(size_t index);
+    void ScheduleWake(size_t index, Frontier::Clock::time_point when);
+    void OnRobotsFetched(const UrlTask& task, const HttpClient::HttpResponse& response);
     void WorkerThread();
-    void ProcessUrl(const std::string& url, int depth);
-    bool AddUrlToQueue(const std::string& url, int depth);
+    void ProcessUrl(const UrlTask& task, const HttpClient::HttpResponse& response);
+    void FinishTask(const UrlTask& task, size_t fetcher);
+    void AddUrlsToQueue(const std::vector<std::string>& urls, int depth);
+    bool AddUrlToQueue(UrlTask task);
     bool ShouldProcessUrl(const std::string& url);
+    void RegisterMetrics();
+    void MetricsDumpThread();
+    void CheckpointThread();
+    bool ResumeFromCheckpoint();
+    void WriteCheckpoint();
+    void ReportClientStats();
+    HttpClient::PoolStats CollectPoolStats() const;
 
     Config& config_;
     Database& db_;
-    HttpClient http_client_;
 
-    //  URL  
-    std::queue<UrlTask> url_queue_;
-    std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
+    // Загрузчик: свой поток, io_context и пул соединений. SSL-контекст
+    // и кэш TLS-сессий у всех загрузчиков общие (http_context_).
+    // wake_timer будит загрузчик, когда освободится следующий хост.
+    struct Fetcher {
+        explicit Fetcher(std::shared_ptr<HttpClientContext> context)
+            : client(std::move(context)), wake_timer(client.GetIoContext()) {}
 
-    //  URL
-    std::unordered_set<std::string> visited_urls_;
-    std::mutex visited_mutex_;
+        HttpClient client;
+        net::steady_timer wake_timer;
+        Frontier::Clock::time_point wake_at = Frontier::Clock::time_point::max();
+        std::thread thread;
+    };
+    std::shared_ptr<HttpClientContext> http_context_;
+    std::vector<std::unique_ptr<Fetcher>> fetchers_;
+    std::atomic<size_t> next_fetcher_{ 0 };
 
-    //  
+    // Очередь URL для обработки: приоритеты, задержки по хостам, хвост на диске
+    Frontier frontier_;
+
+    // Загруженные страницы, ожидающие разбора рабочими потоками
+    std::queue<FetchedPage> page_queue_;
+    std::mutex page_mutex_;
+    std::condition_variable page_cv_;
+
+    // Посещенные URL (отпечатки)
+    SeenSet seen_urls_;
+
+    // Загрузки от выборки из очереди до конца индексации: попадают в контрольную
+    // точку, чтобы после сбоя их URL не потерялись
+    std::unordered_map<std::string, UrlTask> in_flight_tasks_;
+    std::mutex in_flight_tasks_mutex_;
+    // Переходы URL между seen_urls_, frontier_ и in_flight_tasks_ берут его
+    // на чтение, запись контрольной точки - на запись
+    std::shared_mutex checkpoint_mutex_;
+    std::thread checkpoint_thread_;
+
+    // Загрузчики выполняют все загрузки, рабочие потоки разбирают
+    // и индексируют загруженные страницы
     std::vector<std::thread> workers_;
+    // Страницы от начала загрузки до конца индексации; не больше max_concurrent_fetches
+    std::atomic<int> in_flight_{ 0 };
+
+    // Метрики краулера (периодически сбрасываются в файл)
+    struct MetricIds {
+        Metrics::Id fetch_seconds;
+        Metrics::Id fetch_bytes;
+        Metrics::Id fetched_bytes_total;
+        Metrics::Id transferred_bytes_total;
+        Metrics::Id parse_seconds;
+        Metrics::Id index_seconds;
+        Metrics::Id pages_indexed;
+        Metrics::Id pages_failed;
+        Metrics::Id pages_skipped;
+        Metrics::Id pages_not_modified;
+        Metrics::Id queue_size;
+        Metrics::Id queue_spilled;
+        Metrics::Id fetches_in_flight;
+        Metrics::Id pool_hits;
+        Metrics::Id pool_misses;
+        Metrics::Id setup_saved_ms;
+        Metrics::Id tls_full;
+        Metrics::Id tls_resumed;
+        Metrics::Id dns_hits;
+        Metrics::Id dns_negative_hits;
+        Metrics::Id dns_misses;
+        Metrics::Id dns_coalesced;
+    };
+    MetricIds metric_ids_{};
+    // Последние учтенные снимки статистики: счетчики растут на разницу
+    HttpClient::PoolStats reported_pool_stats_{};
+    HttpClientContext::TlsStats reported_tls_stats_{};
+    DnsCache::Stats reported_dns_stats_{};
+    std::thread metrics_thread_;
 
-    //   
+    // Статистика и управление
     std::atomic<bool> running_{ false };
     std::atomic<int> processed_count_{ 0 };
     std::atomic<int> error_count_{ 0 };
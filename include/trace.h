@@ -0,0 +1,106 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Трассировка одного запроса. Активная трассировка хранится в thread_local,
+// поэтому TraceSpan в любом месте обработчика (в том числе в Database)
+// записывает время этапа без передачи контекста через параметры.
+// Если трассировка не активна, спан стоит одно чтение указателя.
+class RequestTrace {
+public:
+    static constexpr int kMaxSpans = 16;
+
+    struct Span {
+        const char* name;
+        int64_t start_us;
+        int64_t duration_us;
+    };
+
+    explicit RequestTrace(std::string route);
+    ~RequestTrace();
+
+    RequestTrace(const RequestTrace&) = delete;
+    RequestTrace& operator=(const RequestTrace&) = delete;
+
+    static RequestTrace* Current() { return current_; }
+
+    void AddSpan(const char* name, std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end);
+    void SetTerms(const std::vector<std::string>& terms) { terms_ = terms; }
+
+    int64_t ElapsedUs() const;
+    std::chrono::steady_clock::time_point Start() const { return start_; }
+    const std::string& Route() const { return route_; }
+    const std::vector<std::string>& Terms() const { return terms_; }
+    const Span* Spans() const { return spans_; }
+    int SpanCount() const { return span_count_; }
+
+private:
+    static thread_local RequestTrace* current_;
+
+    RequestTrace* previous_;
+    std::string route_;
+    std::vector<std::string> terms_;
+    std::chrono::steady_clock::time_point start_;
+    Span spans_[kMaxSpans];
+    int span_count_ = 0;
+};
+
+// RAII-таймер этапа: при выходе из области видимости добавляет спан в текущую трассировку
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name) : name_(name), trace_(RequestTrace::Current()) {
+        if (trace_) start_ = std::chrono::steady_clock::now();
+    }
+    ~TraceSpan() {
+        if (trace_) trace_->AddSpan(name_, start_, std::chrono::steady_clock::now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    RequestTrace* trace_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Журнал медленных запросов: последние N запросов дольше порога с полной разбивкой по этапам
+class SlowQueryLog {
+public:
+    struct Entry {
+        std::chrono::system_clock::time_point time;
+        std::string route;
+        std::vector<std::string> terms;
+        int64_t total_us = 0;
+        std::vector<RequestTrace::Span> spans;
+    };
+
+    static SlowQueryLog& Instance();
+
+    void Configure(int threshold_ms, size_t capacity, const std::string& log_file);
+    bool Enabled() const { return threshold_us_ > 0; }
+
+    // Сохраняет трассировку, если запрос превысил порог
+    void Record(const RequestTrace& trace);
+    std::vector<Entry> Recent(size_t count) const;
+
+    static std::string Format(const Entry& entry);
+
+private:
+    SlowQueryLog() = default;
+
+    int64_t threshold_us_ = 0;
+    size_t capacity_ = 64;
+    std::string log_file_;
+    mutable std::mutex mutex_;
+    std::deque<Entry> entries_;
+};
+
+#endif // TRACE_H
@@ -0,0 +1,37 @@
+#include "admission_controller.h"
+
+bool AdmissionController::TryAdmit() {
+    // Сначала занимаем место, затем проверяем лимиты: так проверка и захват атомарны
+    int in_flight = in_flight_.fetch_add(1, std::memory_order_relaxed) + 1;
+    int queued = queued_.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    bool admit = in_flight <= settings_.max_in_flight && queued <= settings_.max_queue_depth;
+
+    // В адаптивном режиме не ставим запрос в очередь, пока она уже дает задержку выше цели.
+    // Когда очередь опустеет, следующие запросы пройдут сразу и среднее ожидание упадет.
+    if (admit && settings_.adaptive && queued > 1 &&
+        queue_wait_ewma_us_.load(std::memory_order_relaxed) > settings_.queue_wait_target_ms * 1000LL) {
+        admit = false;
+    }
+
+    if (!admit) {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return admit;
+}
+
+void AdmissionController::OnStart(std::chrono::steady_clock::duration queue_wait) {
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+
+    // EWMA с коэффициентом 1/8; гонки между потоками лишь слегка огрубляют оценку
+    int64_t sample = std::chrono::duration_cast<std::chrono::microseconds>(queue_wait).count();
+    int64_t average = queue_wait_ewma_us_.load(std::memory_order_relaxed);
+    queue_wait_ewma_us_.store(average + (sample - average) / 8, std::memory_order_relaxed);
+}
+
+void AdmissionController::OnFinish() {
+    in_flight_.fetch_sub(1, std::memory_order_relaxed);
+}
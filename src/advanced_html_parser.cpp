@@ -8,11 +8,11 @@ std::string AdvancedHtmlParser::ExtractText(const std::string& html) {
     RemoveComments(text);
     RemoveScriptsAndStyles(text);
 
-    //   HTML 
+    // Удаляем все HTML теги
     std::regex tag_regex("<[^>]*>");
     text = std::regex_replace(text, tag_regex, " ");
 
-    //  HTML entities
+    // Заменяем HTML entities
     std::regex nbsp_regex("&nbsp;");
     text = std::regex_replace(text, nbsp_regex, " ");
 
@@ -28,11 +28,11 @@ std::string AdvancedHtmlParser::ExtractText(const std::string& html) {
     std::regex quot_regex("&quot;");
     text = std::regex_replace(text, quot_regex, "\"");
 
-    //   
+    // Удаляем множественные пробелы
     std::regex space_regex("\\s+");
     text = std::regex_replace(text, space_regex, " ");
 
-    //    
+    // Обрезаем пробелы по краям
     text.erase(0, text.find_first_not_of(" \t\n\r\f\v"));
     text.erase(text.find_last_not_of(" \t\n\r\f\v") + 1);
 
@@ -40,7 +40,7 @@ std::string AdvancedHtmlParser::ExtractText(const std::string& html) {
 }
 
 void AdvancedHtmlParser::RemoveComments(std::string& html) {
-    //       
+    // Удаляем многострочные комментарии с помощью итеративного подхода
     size_t start_pos = 0;
     while ((start_pos = html.find("<!--", start_pos)) != std::string::npos) {
         size_t end_pos = html.find("-->", start_pos);
@@ -52,24 +52,24 @@ void AdvancedHtmlParser::RemoveComments(std::string& html) {
 }
 
 void AdvancedHtmlParser::RemoveScriptsAndStyles(std::string& html) {
-    //  script 
+    // Удаляем script теги
     size_t start_pos = 0;
     while ((start_pos = html.find("<script", start_pos)) != std::string::npos) {
         size_t end_pos = html.find("</script>", start_pos);
         if (end_pos == std::string::npos) {
             break;
         }
-        html.erase(start_pos, end_pos - start_pos + 9); // 9 =  "</script>"
+        html.erase(start_pos, end_pos - start_pos + 9); // 9 = длина "</script>"
     }
 
-    //  style 
+    // Удаляем style теги
     start_pos = 0;
     while ((start_pos = html.find("<style", start_pos)) != std::string::npos) {
         size_t end_pos = html.find("</style>", start_pos);
         if (end_pos == std::string::npos) {
             break;
         }
-        html.erase(start_pos, end_pos - start_pos + 8); // 8 =  "</style>"
+        html.erase(start_pos, end_pos - start_pos + 8); // 8 = длина "</style>"
     }
 }
 
@@ -79,7 +79,7 @@ std::string AdvancedHtmlParser::GetPageTitle(const std::string& html) {
         return "";
     }
 
-    title_start += 7; //  "<title>"
+    title_start += 7; // Длина "<title>"
     size_t title_end = html.find("</title>", title_start);
     if (title_end == std::string::npos) {
         return "";
@@ -98,7 +98,7 @@ std::vector<std::string> AdvancedHtmlParser::ExtractMetaKeywords(const std::stri
             break;
         }
 
-        content_start += 9; //  "content=\""
+        content_start += 9; // Длина "content=\""
         size_t content_end = html.find("\"", content_start);
         if (content_end == std::string::npos) {
             break;
@@ -106,7 +106,7 @@ std::vector<std::string> AdvancedHtmlParser::ExtractMetaKeywords(const std::stri
 
         std::string content = html.substr(content_start, content_end - content_start);
 
-        //     
+        // Разделяем ключевые слова по запятым
         size_t keyword_start = 0;
         while (keyword_start < content.length()) {
             size_t keyword_end = content.find(',', keyword_start);
@@ -116,7 +116,7 @@ std::vector<std::string> AdvancedHtmlParser::ExtractMetaKeywords(const std::stri
 
             std::string keyword = content.substr(keyword_start, keyword_end - keyword_start);
 
-            //  
+            // Убираем пробелы
             keyword.erase(0, keyword.find_first_not_of(" \t"));
             keyword.erase(keyword.find_last_not_of(" \t") + 1);
 
@@ -144,7 +144,7 @@ std::string AdvancedHtmlParser::ExtractMetaDescription(const std::string& html)
         return "";
     }
 
-    content_start += 9; //  "content=\""
+    content_start += 9; // Длина "content=\""
     size_t content_end = html.find("\"", content_start);
     if (content_end == std::string::npos) {
         return "";
@@ -1,50 +1,308 @@
 #include "beast_http_server.h"
 #include "html_parser.h"
+#include "json.h"
+#include "html_template.h"
+#include "metrics.h"
+#include "trace.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
 #include <csignal>
+#include <chrono>
+#include <charconv>
+#include <unordered_set>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
-//     
+// Глобальный флаг для обработки сигналов
 std::atomic<bool> g_signal_received{ false };
+std::atomic<bool> g_reload_requested{ false };
+
+namespace {
+
+// Привязывает поток к ядру. Если ОС не поддерживает привязку, поток остаётся свободным.
+void PinThreadToCpu(std::thread& thread, unsigned cpu) {
+#if defined(_WIN32)
+    SetThreadAffinityMask(thread.native_handle(), static_cast<DWORD_PTR>(1) << (cpu % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#else
+    (void)thread;
+    (void)cpu;
+#endif
+}
+
+// Исходные тексты страниц. Разбираются в HtmlTemplate один раз в конструкторе сервера.
+const char kSearchPageTemplate[] =
+    "<!DOCTYPE html>"
+    "<html>"
+    "<head>"
+    "<title>Search Engine</title>"
+    "<meta charset='UTF-8'>"
+    "<meta name='viewport' content='width=device-width, initial-scale=1.0'>"
+    "<style>"
+    "body { font-family: Arial, sans-serif; margin: 40px; background-color: #f5f5f5; }"
+    ".container { max-width: 800px; margin: 0 auto; background: white; padding: 30px; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }"
+    ".search-box { text-align: center; margin-bottom: 30px; }"
+    "h1 { color: #4285f4; margin-bottom: 30px; }"
+    "input[type=text] { width: 70%; padding: 12px; font-size: 16px; border: 1px solid #ddd; border-radius: 24px; outline: none; }"
+    "input[type=text]:focus { border-color: #4285f4; box-shadow: 0 0 5px rgba(66, 133, 244, 0.3); }"
+    "input[type=submit] { padding: 12px 24px; font-size: 16px; background-color: #4285f4; color: white; border: none; border-radius: 24px; cursor: pointer; margin-left: 10px; }"
+    "input[type=submit]:hover { background-color: #3367d6; }"
+    ".footer { text-align: center; margin-top: 40px; color: #666; font-size: 14px; }"
+    "</style>"
+    "</head>"
+    "<body>"
+    "<div class='container'>"
+    "<div class='search-box'>"
+    "<h1>Search Engine</h1>"
+    "<form method='get' action='/search'>"
+    "<input type='text' name='q' value='{{query}}' placeholder='Enter your search query...'>"
+    "<input type='submit' value='Search'>"
+    "</form>"
+    "</div>"
+    "<div class='footer'>"
+    "Built with C++, Boost.Beast and PostgreSQL"
+    "</div>"
+    "</div>"
+    "</body>"
+    "</html>";
+
+const char kResultsHeaderTemplate[] =
+    "<!DOCTYPE html>"
+    "<html>"
+    "<head>"
+    "<title>Search Results for \"{{query}}\"</title>"
+    "<meta charset='UTF-8'>"
+    "<meta name='viewport' content='width=device-width, initial-scale=1.0'>"
+    "<style>"
+    "body { font-family: Arial, sans-serif; margin: 0; padding: 0; background-color: #f5f5f5; }"
+    ".header { background: white; padding: 20px; border-bottom: 1px solid #e0e0e0; }"
+    ".container { max-width: 800px; margin: 0 auto; }"
+    ".search-box { display: flex; align-items: center; }"
+    "h1 { color: #4285f4; margin: 0; margin-right: 30px; font-size: 24px; }"
+    "input[type=text] { flex: 1; padding: 12px; font-size: 16px; border: 1px solid #ddd; border-radius: 24px; outline: none; }"
+    "input[type=text]:focus { border-color: #4285f4; }"
+    "input[type=submit] { padding: 12px 24px; font-size: 16px; background-color: #4285f4; color: white; border: none; border-radius: 24px; cursor: pointer; margin-left: 10px; }"
+    ".results { background: white; margin: 20px auto; max-width: 800px; padding: 20px; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }"
+    ".result { margin-bottom: 25px; padding-bottom: 20px; border-bottom: 1px solid #f0f0f0; }"
+    ".result:last-child { border-bottom: none; margin-bottom: 0; }"
+    ".result-title { font-size: 18px; color: #1a0dab; text-decoration: none; font-weight: normal; margin: 0 0 5px 0; display: block; }"
+    ".result-title:hover { text-decoration: underline; }"
+    ".result-url { color: #006621; font-size: 14px; margin: 0 0 8px 0; }"
+    ".result-snippet { color: #545454; font-size: 14px; line-height: 1.4; margin: 0; }"
+    ".result-relevance { color: #70757a; font-size: 12px; margin-top: 5px; }"
+    ".no-results { text-align: center; padding: 40px; color: #70757a; }"
+    ".results-count { color: #70757a; font-size: 14px; margin-bottom: 20px; }"
+    "</style>"
+    "</head>"
+    "<body>"
+    "<div class='header'>"
+    "<div class='container'>"
+    "<div class='search-box'>"
+    "<h1>Search Engine</h1>"
+    "<form method='get' action='/search' style='display: flex; flex: 1;'>"
+    "<input type='text' name='q' value='{{query}}'>"
+    "<input type='submit' value='Search'>"
+    "</form>"
+    "</div>"
+    "</div>"
+    "</div>"
+    "<div class='results'>"
+    "<div class='results-count'>Found {{count}} results for \"{{query}}\"</div>";
+
+const char kResultItemTemplate[] =
+    "<div class='result'>"
+    "<a class='result-title' href='{{url}}' target='_blank'>{{title}}</a>"
+    "<div class='result-url'>{{url}}</div>"
+    "<div class='result-snippet'>{{snippet}}</div>"
+    "<div class='result-relevance'>Relevance score: {{relevance}}</div>"
+    "</div>";
+
+const char kNoResultsHtml[] =
+    "<div class='no-results'>"
+    "<h3>No results found</h3>"
+    "<p>Try different keywords or check your spelling.</p>"
+    "</div>";
+
+const char kPartialResultsHtml[] =
+    "<div class='results-count'>The search ran out of time: results may be incomplete.</div>";
+
+const char kResultsFooterHtml[] =
+    "</div>"
+    "</body>"
+    "</html>";
+
+const char kErrorPageTemplate[] =
+    "<!DOCTYPE html>"
+    "<html>"
+    "<head>"
+    "<title>Error</title>"
+    "<meta charset='UTF-8'>"
+    "<meta name='viewport' content='width=device-width, initial-scale=1.0'>"
+    "<style>"
+    "body { font-family: Arial, sans-serif; margin: 40px; background-color: #f5f5f5; }"
+    ".container { max-width: 600px; margin: 0 auto; background: white; padding: 30px; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); text-align: center; }"
+    ".error { color: #d93025; font-size: 18px; margin-bottom: 20px; }"
+    "a { color: #4285f4; text-decoration: none; }"
+    "a:hover { text-decoration: underline; }"
+    "</style>"
+    "</head>"
+    "<body>"
+    "<div class='container'>"
+    "<h1>Error</h1>"
+    "<div class='error'>{{message}}</div>"
+    "<p><a href='/'>Back to search</a></p>"
+    "</div>"
+    "</body>"
+    "</html>";
+
+// Целое число в строку без выделения памяти
+std::string_view FormatInt(char (&buf)[24], long long value) {
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+    return std::string_view(buf, static_cast<size_t>(end - buf));
+}
+
+} // namespace
 
 void signal_handler(int signal) {
     std::cout << "Received signal " << signal << ", shutting down gracefully..." << std::endl;
     g_signal_received = true;
 }
 
+void reload_signal_handler(int) {
+    // В обработчике сигнала только выставляем флаг, снимок собирает фоновый поток
+    g_reload_requested = true;
+}
+
 BeastHttpServer::BeastHttpServer(Config& config, Database& db)
-    : config_(config), db_(db), ioc_(), acceptor_(ioc_) {
+    : config_(config), db_(db),
+    admission_({ config.GetMaxInFlight(), config.GetMaxQueueDepth(),
+        config.GetAdaptiveShedding(), config.GetQueueWaitTargetMs() }),
+    search_page_template_(kSearchPageTemplate),
+    results_header_template_(kResultsHeaderTemplate),
+    result_item_template_(kResultItemTemplate),
+    error_page_template_(kErrorPageTemplate),
+    ioc_(), acceptor_(ioc_),
+    handler_pool_(static_cast<std::size_t>(std::max(config.GetServerThreads(), 1))) {
+    RegisterMetrics();
+    SlowQueryLog::Instance().Configure(config_.GetSlowQueryMs(),
+        static_cast<size_t>(std::max(config_.GetTraceBufferSize(), 1)), config_.GetSlowQueryLog());
+
+    // Начальный снимок состояния. Сведения об индексе добавляются в Start,
+    // до приема первых соединений.
+    auto initial = std::make_shared<ServingState>();
+    initial->version = 1;
+    initial->loaded_at = std::chrono::system_clock::now();
+    initial->ApplyConfig(config_);
+
+    // Стартовая страница не зависит от запроса: собираем и сжимаем ответ один раз
+    auto& identity = initial->landing_responses[static_cast<int>(ContentEncoding::Identity)];
+    identity = MakeResponse(http::status::ok, 11, "text/html", GenerateSearchPage(""));
+    identity.set(http::field::vary, "Accept-Encoding");
+
+    for (auto encoding : { ContentEncoding::Gzip, ContentEncoding::Deflate }) {
+        auto& variant = initial->landing_responses[static_cast<int>(encoding)];
+        variant = identity;
+
+        std::string compressed;
+        if (Compressor(encoding, Z_BEST_COMPRESSION).Compress(identity.body(), compressed)) {
+            variant.body() = std::move(compressed);
+            variant.set(http::field::content_encoding, EncodingName(encoding));
+            variant.prepare_payload();
+        }
+    }
+    state_.Store(std::move(initial));
 }
 
 BeastHttpServer::~BeastHttpServer() {
     Stop();
 }
 
+void BeastHttpServer::RegisterMetrics() {
+    auto& metrics = Metrics::Instance();
+    const char* route_names[kRouteCount] = { "/", "/search", "/api/search", "/api/search/batch", "/metrics", "other" };
+
+    for (int i = 0; i < kRouteCount; ++i) {
+        std::string labels = std::string("route=\"") + route_names[i] + "\"";
+        metric_ids_.requests[i] = metrics.RegisterCounter("http_requests_total",
+            "HTTP requests handled, by route", labels);
+        metric_ids_.latency[i] = metrics.RegisterHistogram("http_request_duration_seconds",
+            "Time to handle an HTTP request, by route", Metrics::LatencyBuckets(), labels);
+    }
+
+    metric_ids_.render_seconds = metrics.RegisterHistogram("search_render_seconds",
+        "Time to render a results page or JSON payload", Metrics::LatencyBuckets());
+    metric_ids_.queue_wait_seconds = metrics.RegisterHistogram("http_queue_wait_seconds",
+        "Time a request waited for a handler thread", Metrics::LatencyBuckets());
+    metric_ids_.connections_total = metrics.RegisterCounter("http_connections_total",
+        "Accepted HTTP connections");
+    metric_ids_.open_connections = metrics.RegisterGauge("http_open_connections",
+        "Currently open HTTP connections");
+    metric_ids_.rejected_connections = metrics.RegisterCounter("http_rejected_connections_total",
+        "Connections refused by the per-IP limit");
+    metric_ids_.rejected_requests = metrics.RegisterCounter("http_rejected_requests_total",
+        "Requests rejected with 503 by admission control");
+    metric_ids_.cache_hits = metrics.RegisterCounter("http_cache_hits_total",
+        "Responses served from prebuilt or cached data");
+    metric_ids_.cache_misses = metrics.RegisterCounter("http_cache_misses_total",
+        "Cacheable responses that had to be rendered");
+    metric_ids_.state_version = metrics.RegisterGauge("serving_state_version",
+        "Version of the serving state snapshot in use");
+    metric_ids_.index_generation = metrics.RegisterGauge("index_generation",
+        "Index generation of the serving state snapshot");
+    metric_ids_.partial_results = metrics.RegisterCounter("search_partial_results_total",
+        "Searches answered with partial results after their time budget ran out");
+}
+
 void BeastHttpServer::Start() {
     try {
-        //   
+        // Устанавливаем обработчики сигналов
         std::signal(SIGINT, signal_handler);
         std::signal(SIGTERM, signal_handler);
+#ifdef SIGHUP
+        std::signal(SIGHUP, reload_signal_handler);
+#endif
 
         auto const address = net::ip::make_address(config_.GetServerHost());
         auto const port = static_cast<unsigned short>(config_.GetServerPort());
 
         tcp::endpoint endpoint{ address, port };
 
-        //  acceptor
-        acceptor_.open(endpoint.protocol());
-        acceptor_.set_option(net::socket_base::reuse_address(true));
-        acceptor_.bind(endpoint);
-        acceptor_.listen();
+        // Сведения об индексе читаются до приема соединений, чтобы ETag выдавались с первого запроса
+        ReloadState(false);
+        state_thread_ = std::thread(&BeastHttpServer::StateRefreshThread, this);
+
+        if (config_.GetReusePort()) {
+            per_core_ = StartReactors(endpoint);
+        }
+
+        if (!per_core_) {
+            // Открываем acceptor
+            acceptor_.open(endpoint.protocol());
+            acceptor_.set_option(net::socket_base::reuse_address(true));
+            acceptor_.bind(endpoint);
+            acceptor_.listen();
 
-        std::cout << "HTTP Server started on " << config_.GetServerHost() << ":" << config_.GetServerPort() << std::endl;
+            // Первый accept ставится до запуска потоков: иначе ioc_.run() в рабочем
+            // потоке может не найти работы и сразу завершиться
+            Listen(acceptor_, ioc_);
+            CreateWorkerThreads();
+        }
 
-        CreateWorkerThreads();
-        Listen();
+        std::cout << "HTTP Server started on " << config_.GetServerHost() << ":" << config_.GetServerPort();
+        if (per_core_) {
+            std::cout << " (" << reactors_.size() << " reactors with SO_REUSEPORT)";
+        }
+        std::cout << std::endl;
 
-        //     
+        // Запускаем обработку в текущем потоке
         Run();
 
     }
@@ -64,14 +322,37 @@ void BeastHttpServer::Stop() {
             thread.join();
         }
     }
+
+    for (auto& reactor : reactors_) {
+        reactor->ioc.stop();
+    }
+    for (auto& reactor : reactors_) {
+        if (reactor->thread.joinable()) {
+            reactor->thread.join();
+        }
+    }
+    // Реакторы не уничтожаются здесь: их сессии могут еще лежать в очереди
+    // handler_pool_, порядок уничтожения задан объявлением членов
+
+    if (state_thread_.joinable()) {
+        state_thread_.join();
+    }
+    handler_pool_.stop();
+    handler_pool_.join();
 }
 
 void BeastHttpServer::Run() {
     std::cout << "Server is running. Press Ctrl+C to stop." << std::endl;
 
-    //     
+    // Основной цикл с проверкой сигналов
     while (!stopped_ && !g_signal_received) {
-        ioc_.run_for(std::chrono::milliseconds(100));
+        if (per_core_) {
+            // Реакторы работают в своих потоках, основной только ждёт сигнала
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        else {
+            ioc_.run_for(std::chrono::milliseconds(100));
+        }
     }
 
     std::cout << "Server stopped gracefully" << std::endl;
@@ -79,48 +360,146 @@ void BeastHttpServer::Run() {
 
 void BeastHttpServer::CreateWorkerThreads() {
     int thread_count = config_.GetServerThreads();
+    unsigned cpu_count = std::max(std::thread::hardware_concurrency(), 1u);
     worker_threads_.reserve(thread_count);
     for (int i = 0; i < thread_count; ++i) {
         worker_threads_.emplace_back([this]() {
             ioc_.run();
             });
+        if (config_.GetPinThreads()) {
+            PinThreadToCpu(worker_threads_.back(), static_cast<unsigned>(i) % cpu_count);
+        }
     }
 }
 
-void BeastHttpServer::Listen() {
+void BeastHttpServer::StateRefreshThread() {
+    const auto interval = std::chrono::seconds(std::max(config_.GetGenerationPollInterval(), 1));
+    auto next_poll = std::chrono::steady_clock::now() + interval;
+
+    while (!stopped_ && !g_signal_received) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        if (g_reload_requested.exchange(false)) {
+            if (ReloadState(true)) {
+                std::cout << "Serving state reloaded, version " << state_.Load()->version << std::endl;
+            }
+            next_poll = std::chrono::steady_clock::now() + interval;
+            continue;
+        }
+
+        if (std::chrono::steady_clock::now() < next_poll) {
+            continue;
+        }
+
+        // Индекс изменился: публикуем снимок с новым поколением
+        if (db_.GetIndexGeneration() != state_.Load()->index.generation) {
+            ReloadState(false);
+        }
+        next_poll = std::chrono::steady_clock::now() + interval;
+    }
+}
+
+bool BeastHttpServer::ReloadState(bool reload_config) {
+    // Новый снимок собирается целиком в этом потоке. Запросы продолжают работать
+    // со старым и не ждут ни чтения файла, ни обращений к базе.
+    auto current = state_.Load();
+    auto next = std::make_shared<ServingState>(*current);
+    next->version = current->version + 1;
+    next->loaded_at = std::chrono::system_clock::now();
+
+    // Исключение здесь завершило бы state_thread_ вместе с сервером
+    // (Config::Load разбирает числа через std::stoi), поэтому при любой ошибке
+    // остается текущий снимок
+    try {
+        if (reload_config) {
+            // Файл читается в отдельный объект: config_ обработчики читают без блокировок
+            Config fresh;
+            if (fresh.Load(config_.GetFileName())) {
+                next->ApplyConfig(fresh);
+            }
+            else {
+                std::cerr << "State reload: cannot read " << config_.GetFileName()
+                    << ", keeping current settings" << std::endl;
+            }
+        }
+
+        next->index = db_.GetIndexStats();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "State reload failed: " << e.what()
+            << ", keeping state version " << current->version << std::endl;
+        return false;
+    }
+
+    auto& metrics = Metrics::Instance();
+    metrics.SetGauge(metric_ids_.state_version, static_cast<int64_t>(next->version));
+    metrics.SetGauge(metric_ids_.index_generation, static_cast<int64_t>(next->index.generation));
+    state_.Store(std::move(next));
+    return true;
+}
+
+bool BeastHttpServer::StartReactors(const tcp::endpoint& endpoint) {
+#ifdef SO_REUSEPORT
+    using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+    int reactor_count = std::max(config_.GetServerThreads(), 1);
+    unsigned cpu_count = std::max(std::thread::hardware_concurrency(), 1u);
+    reactors_.reserve(reactor_count);
+    per_core_ = true;
+
+    for (int i = 0; i < reactor_count; ++i) {
+        auto reactor = std::make_unique<Reactor>();
+        reactor->acceptor.open(endpoint.protocol());
+        reactor->acceptor.set_option(net::socket_base::reuse_address(true));
+        reactor->acceptor.set_option(reuse_port(true));
+        reactor->acceptor.bind(endpoint);
+        reactor->acceptor.listen();
+        Listen(reactor->acceptor, reactor->ioc);
+        reactors_.push_back(std::move(reactor));
+    }
+
+    for (int i = 0; i < reactor_count; ++i) {
+        Reactor& reactor = *reactors_[i];
+        reactor.thread = std::thread([&reactor]() {
+            reactor.ioc.run();
+            });
+        if (config_.GetPinThreads()) {
+            PinThreadToCpu(reactor.thread, static_cast<unsigned>(i) % cpu_count);
+        }
+    }
+    return true;
+#else
+    (void)endpoint;
+    std::cerr << "SO_REUSEPORT is not supported on this platform, using a shared acceptor" << std::endl;
+    return false;
+#endif
+}
+
+void BeastHttpServer::Listen(tcp::acceptor& acceptor, net::io_context& ioc) {
     if (stopped_ || g_signal_received) return;
 
-    auto socket = std::make_shared<tcp::socket>(ioc_);
+    // В общем режиме каждое соединение получает собственный strand: обработчики одной
+    // сессии никогда не выполняются параллельно, хотя ioc_ обслуживают несколько потоков.
+    // Реактор однопоточный, и strand ему не нужен.
+    auto executor = per_core_ ? net::any_io_executor(ioc.get_executor())
+        : net::any_io_executor(net::make_strand(ioc));
 
-    acceptor_.async_accept(*socket, [this, socket](beast::error_code ec) {
+    acceptor.async_accept(executor, [this, &acceptor, &ioc](beast::error_code ec, tcp::socket socket) {
         if (!ec) {
-            //     
-            std::thread([this, socket]() {
-                try {
-                    beast::flat_buffer buffer;
-                    http::request<http::string_body> req;
+            beast::error_code endpoint_ec;
+            auto address = socket.remote_endpoint(endpoint_ec).address();
 
-                    //  
-                    http::read(*socket, buffer, req);
-
-                    //  
-                    HandleRequest(std::move(req), socket);
-                }
-                catch (const std::exception& e) {
-                    std::cerr << "Request handling error: " << e.what() << std::endl;
-                    try {
-                        http::response<http::string_body> res{ http::status::internal_server_error, 11 };
-                        res.set(http::field::server, "SearchEngine/1.0");
-                        res.set(http::field::content_type, "text/html");
-                        res.body() = GenerateErrorPage("Internal server error");
-                        res.prepare_payload();
-                        http::write(*socket, res);
-                    }
-                    catch (...) {
-                        //       
-                    }
-                }
-                }).detach();
+            if (endpoint_ec) {
+                // Клиент успел отключиться
+            }
+            else if (AcquireConnectionSlot(address)) {
+                std::make_shared<HttpSession>(std::move(socket), *this, address)->Run();
+            }
+            else {
+                // Превышен лимит соединений с одного адреса: закрываем сразу
+                Metrics::Instance().Increment(metric_ids_.rejected_connections);
+                socket.close(endpoint_ec);
+            }
         }
         else {
             if (ec != beast::errc::operation_canceled) {
@@ -128,54 +507,374 @@ void BeastHttpServer::Listen() {
             }
         }
 
-        //      
+        // Продолжаем принимать соединения если не остановлено
         if (!stopped_ && !g_signal_received) {
-            Listen();
+            Listen(acceptor, ioc);
+        }
+        });
+}
+
+bool BeastHttpServer::AcquireConnectionSlot(const net::ip::address& address) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    int& count = connections_per_ip_[address];
+    if (count >= config_.GetMaxConnectionsPerIp()) {
+        if (count == 0) {
+            connections_per_ip_.erase(address);
+        }
+        return false;
+    }
+    ++count;
+    return true;
+}
+
+void BeastHttpServer::ReleaseConnectionSlot(const net::ip::address& address) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    auto it = connections_per_ip_.find(address);
+    if (it != connections_per_ip_.end() && --it->second <= 0) {
+        connections_per_ip_.erase(it);
+    }
+}
+
+HttpSession::HttpSession(tcp::socket&& socket, BeastHttpServer& server, const net::ip::address& address)
+    : stream_(std::move(socket)), server_(server), address_(address) {
+    auto& metrics = Metrics::Instance();
+    metrics.Increment(server_.metric_ids_.connections_total);
+    metrics.AddGauge(server_.metric_ids_.open_connections, 1);
+}
+
+HttpSession::~HttpSession() {
+    Metrics::Instance().AddGauge(server_.metric_ids_.open_connections, -1);
+    server_.ReleaseConnectionSlot(address_);
+}
+
+void HttpSession::Run() {
+    // Переходим на strand сессии перед первой операцией
+    net::dispatch(stream_.get_executor(),
+        beast::bind_front_handler(&HttpSession::DoRead, shared_from_this()));
+}
+
+void HttpSession::DoRead() {
+    // Конвейерный запрос уже лежит в буфере: сразу читаем заголовок
+    if (buffer_.size() > 0) {
+        return ReadHeader();
+    }
+
+    // Ожидание следующего запроса на keep-alive соединении ограничено idle-таймаутом.
+    // Как только придут первые байты, начинает действовать таймаут заголовка.
+    stream_.expires_after(std::chrono::seconds(server_.config_.GetKeepAliveTimeout()));
+
+    stream_.async_read_some(buffer_.prepare(kReadChunkSize),
+        beast::bind_front_handler(&HttpSession::OnIdleRead, shared_from_this()));
+}
+
+void HttpSession::OnIdleRead(beast::error_code ec, std::size_t bytes_transferred) {
+    if (ec == net::error::eof) {
+        return DoClose();
+    }
+
+    if (ec) {
+        if (ec != beast::error::timeout && ec != net::error::operation_aborted) {
+            std::cerr << "Request read error: " << ec.message() << std::endl;
+        }
+        return;
+    }
+
+    buffer_.commit(bytes_transferred);
+    ReadHeader();
+}
+
+void HttpSession::ReadHeader() {
+    // Парсер создается заново для каждого запроса
+    parser_.emplace();
+    parser_->header_limit(static_cast<std::uint32_t>(server_.config_.GetMaxHeaderSize()));
+    // Content-Length сверяется с пределом еще при разборе заголовка, когда маршрут
+    // неизвестен: здесь берется больший из пределов, точный - в OnReadHeader
+    parser_->body_limit(static_cast<std::uint64_t>(
+        std::max(server_.config_.GetMaxBodySize(), server_.config_.GetBatchMaxBodySize())));
+
+    // Заголовок целиком должен прийти за header_timeout, даже если клиент шлет по байту
+    stream_.expires_after(std::chrono::seconds(server_.config_.GetHeaderTimeout()));
+
+    http::async_read_header(stream_, buffer_, *parser_,
+        beast::bind_front_handler(&HttpSession::OnReadHeader, shared_from_this()));
+}
+
+void HttpSession::OnReadHeader(beast::error_code ec, std::size_t bytes_transferred) {
+    boost::ignore_unused(bytes_transferred);
+
+    if (ec) {
+        return OnRead(ec, 0);
+    }
+
+    // Пакет запросов POST /api/search/batch больше формы поиска и ограничен отдельно
+    const auto body_limit = static_cast<std::uint64_t>(BeastHttpServer::IsBatchRequest(parser_->get())
+        ? server_.config_.GetBatchMaxBodySize() : server_.config_.GetMaxBodySize());
+    if (parser_->content_length() && *parser_->content_length() > body_limit) {
+        return OnRead(http::error::body_limit, 0);
+    }
+    parser_->body_limit(body_limit);
+
+    // Тело (форма POST /search) читается со своим таймаутом
+    stream_.expires_after(std::chrono::seconds(server_.config_.GetBodyTimeout()));
+
+    http::async_read(stream_, buffer_, *parser_,
+        beast::bind_front_handler(&HttpSession::OnRead, shared_from_this()));
+}
+
+void HttpSession::OnRead(beast::error_code ec, std::size_t bytes_transferred) {
+    boost::ignore_unused(bytes_transferred);
+
+    // Клиент закрыл соединение
+    if (ec == http::error::end_of_stream) {
+        return DoClose();
+    }
+
+    // Превышены лимиты размера: отвечаем и закрываем соединение, поток уже не разобрать
+    if (ec == http::error::header_limit) {
+        return WriteResponse(BeastHttpServer::MakeResponse(http::status::request_header_fields_too_large, 11,
+            "text/html", server_.GenerateErrorPage("Request header too large")), false);
+    }
+    if (ec == http::error::body_limit) {
+        return WriteResponse(BeastHttpServer::MakeResponse(http::status::payload_too_large, 11,
+            "text/html", server_.GenerateErrorPage("Request body too large")), false);
+    }
+
+    if (ec) {
+        if (ec != beast::error::timeout && ec != net::error::operation_aborted) {
+            std::cerr << "Request read error: " << ec.message() << std::endl;
         }
+        return;
+    }
+
+    req_ = parser_->release();
+    parser_.reset();
+
+    ++requests_served_;
+    bool keep_alive = req_.keep_alive() &&
+        requests_served_ < server_.config_.GetMaxKeepAliveRequests() &&
+        !server_.stopped_ && !g_signal_received;
+
+    // Перегрузка: отвечаем сразу, не занимая пул обработчиков
+    if (!server_.admission_.TryAdmit()) {
+        Metrics::Instance().Increment(server_.metric_ids_.rejected_requests);
+        return WriteResponse(server_.MakeOverloadResponse(req_), keep_alive);
+    }
+
+    // Пакетный поиск отвечает потоком и обслуживается отдельно
+    if (BeastHttpServer::IsBatchRequest(req_)) {
+        return StartBatch(keep_alive);
+    }
+
+    if (server_.per_core_) {
+        // В режиме "поток на ядро" запрос выполняется в потоке реактора: соединение
+        // не переходит между ядрами, а параллелизм задаётся числом реакторов
+        server_.admission_.OnStart(std::chrono::steady_clock::duration::zero());
+        auto response = server_.HandleRequest(std::move(req_), address_);
+        server_.admission_.OnFinish();
+        return WriteResponse(std::move(response), keep_alive);
+    }
+
+    // Обработка может блокироваться на базе данных, поэтому уходит в пул обработчиков.
+    // Пока запрос выполняется, сессия не читает из сокета, так что req_ никто не трогает.
+    auto enqueued = std::chrono::steady_clock::now();
+    net::post(server_.handler_pool_, [self = shared_from_this(), enqueued, keep_alive]() {
+        auto& server = self->server_;
+        auto queue_wait = std::chrono::steady_clock::now() - enqueued;
+        server.admission_.OnStart(queue_wait);
+        Metrics::Instance().Observe(server.metric_ids_.queue_wait_seconds,
+            std::chrono::duration<double>(queue_wait).count());
+        auto response = server.HandleRequest(std::move(self->req_), self->address_);
+        server.admission_.OnFinish();
+
+        net::post(self->stream_.get_executor(),
+            [self, response = std::move(response), keep_alive]() mutable {
+                self->WriteResponse(std::move(response), keep_alive);
+            });
         });
 }
 
+void HttpSession::WriteResponse(http::response<http::string_body>&& response, bool keep_alive) {
+    res_ = std::make_shared<http::response<http::string_body>>(std::move(response));
+    res_->keep_alive(keep_alive);
+
+    // Медленный читатель не должен удерживать сессию бесконечно
+    stream_.expires_after(std::chrono::seconds(server_.config_.GetWriteTimeout()));
+
+    http::async_write(stream_, *res_,
+        beast::bind_front_handler(&HttpSession::OnWrite, shared_from_this(), keep_alive));
+}
+
+void HttpSession::OnWrite(bool keep_alive, beast::error_code ec, std::size_t bytes_transferred) {
+    boost::ignore_unused(bytes_transferred);
+
+    if (ec) {
+        if (ec != beast::error::timeout && ec != net::error::operation_aborted) {
+            std::cerr << "Error sending response: " << ec.message() << std::endl;
+        }
+        return;
+    }
+
+    res_.reset();
+
+    if (!keep_alive) {
+        return DoClose();
+    }
+
+    // Следующий запрос (в том числе уже прочитанный в buffer_ конвейерный)
+    DoRead();
+}
+
+void HttpSession::StartBatch(bool keep_alive) {
+    auto enqueued = std::chrono::steady_clock::now();
+    net::post(server_.handler_pool_, [self = shared_from_this(), enqueued, keep_alive]() {
+        auto& server = self->server_;
+        server.admission_.OnStart(std::chrono::steady_clock::now() - enqueued);
+
+        auto state = server.state_.Load();
+        auto plan = std::make_shared<BeastHttpServer::BatchPlan>();
+        http::response<http::string_body> error;
+        if (!server.PrepareBatch(self->req_, *state, *plan, error)) {
+            server.admission_.OnFinish();
+            net::post(self->stream_.get_executor(),
+                [self, error = std::move(error), keep_alive]() mutable {
+                    self->WriteResponse(std::move(error), keep_alive);
+                });
+            return;
+        }
+
+        auto batch = std::make_shared<BatchStream>();
+        batch->lines.resize(plan->queries.size());
+        batch->pending = plan->queries.size();
+        batch->keep_alive = keep_alive;
+        batch->start = enqueued;
+        batch->header.version(self->req_.version());
+        batch->header.result(http::status::ok);
+        batch->header.set(http::field::server, "SearchEngine/1.0");
+        batch->header.set(http::field::content_type, "application/x-ndjson; charset=utf-8");
+        batch->header.keep_alive(keep_alive);
+        batch->header.chunked(true);
+
+        net::post(self->stream_.get_executor(), [self, batch]() {
+            self->BeginBatchStream(batch);
+            });
+
+        // Запросы пакета выполняются параллельно, но занимают не больше половины пула,
+        // чтобы обычные запросы не стояли в очереди за длинным пакетом
+        size_t workers = std::min(plan->queries.size(),
+            static_cast<size_t>(std::max(server.config_.GetServerThreads() / 2, 1)));
+        for (size_t w = 0; w < workers; ++w) {
+            net::post(server.handler_pool_, [self, plan, batch]() {
+                for (size_t i = plan->next_query++; i < plan->queries.size(); i = plan->next_query++) {
+                    std::string line = self->server_.RunBatchQuery(*plan, i);
+                    net::post(self->stream_.get_executor(),
+                        [self, batch, i, line = std::move(line)]() mutable {
+                            self->OnBatchLine(batch, i, std::move(line));
+                        });
+                }
+                });
+        }
+        });
+}
+
+void HttpSession::BeginBatchStream(std::shared_ptr<BatchStream> batch) {
+    batch_ = std::move(batch);
+    batch_->serializer.emplace(batch_->header);
+    batch_->writing = true;
+
+    stream_.expires_after(std::chrono::seconds(server_.config_.GetWriteTimeout()));
+    http::async_write_header(stream_, *batch_->serializer,
+        beast::bind_front_handler(&HttpSession::OnBatchWrite, shared_from_this()));
+}
+
+void HttpSession::OnBatchLine(std::shared_ptr<BatchStream> batch, size_t index, std::string line) {
+    if (!batch->failed) {
+        batch->lines[index] = std::move(line);
+    }
+    if (--batch->pending == 0) {
+        server_.admission_.OnFinish();
+    }
+
+    // Заголовок мог еще не уйти: тогда строка подождет в lines
+    if (batch_ == batch) {
+        WriteBatch();
+    }
+}
+
+void HttpSession::WriteBatch() {
+    auto& batch = *batch_;
+    if (batch.writing || batch.failed) {
+        return;
+    }
+
+    if (batch.next_line < batch.lines.size()) {
+        auto& line = batch.lines[batch.next_line];
+        if (!line) {
+            // Ждем ответа на следующий по порядку запрос
+            return;
+        }
+        batch.current = std::move(*line);
+        line.reset();
+        ++batch.next_line;
+
+        batch.writing = true;
+        stream_.expires_after(std::chrono::seconds(server_.config_.GetWriteTimeout()));
+        net::async_write(stream_, http::make_chunk(net::buffer(batch.current)),
+            beast::bind_front_handler(&HttpSession::OnBatchWrite, shared_from_this()));
+        return;
+    }
+
+    if (!batch.finished) {
+        batch.finished = true;
+        batch.writing = true;
+        stream_.expires_after(std::chrono::seconds(server_.config_.GetWriteTimeout()));
+        net::async_write(stream_, http::make_chunk_last(),
+            beast::bind_front_handler(&HttpSession::OnBatchWrite, shared_from_this()));
+        return;
+    }
+
+    // Пакет полностью отправлен
+    auto& metrics = Metrics::Instance();
+    int route_index = static_cast<int>(BeastHttpServer::Route::ApiBatch);
+    metrics.Increment(server_.metric_ids_.requests[route_index]);
+    metrics.Observe(server_.metric_ids_.latency[route_index],
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - batch.start).count());
+
+    bool keep_alive = batch.keep_alive;
+    batch_.reset();
+
+    if (!keep_alive) {
+        return DoClose();
+    }
+    DoRead();
+}
+
+void HttpSession::OnBatchWrite(beast::error_code ec, std::size_t bytes_transferred) {
+    boost::ignore_unused(bytes_transferred);
+    batch_->writing = false;
+
+    if (ec) {
+        if (ec != beast::error::timeout && ec != net::error::operation_aborted) {
+            std::cerr << "Error sending batch response: " << ec.message() << std::endl;
+        }
+        // Оставшиеся запросы пакета дорабатывают, но их результаты уже не нужны
+        batch_->failed = true;
+        batch_->lines.clear();
+        batch_->lines.resize(batch_->next_line);
+        return;
+    }
+
+    WriteBatch();
+}
 
-//void BeastHttpServer::Listen() {
-//    if (stopped_ || g_signal_received) return;
-//
-//    auto socket = std::make_shared<tcp::socket>(ioc_);
-//
-//    acceptor_.async_accept(*socket, [this, socket](beast::error_code ec) {
-//        if (!ec) {
-//            //    
-//            std::thread([this, socket]() {
-//                try {
-//                    //  
-//                    socket->set_option(net::socket_base::receive_timeout(std::chrono::seconds(10)));
-//                    socket->set_option(net::socket_base::send_timeout(std::chrono::seconds(10)));
-//
-//                    beast::flat_buffer buffer;
-//                    http::request<http::string_body> req;
-//
-//                    //    
-//                    http::read(*socket, buffer, req);
-//
-//                    //  
-//                    HandleRequest(std::move(req), socket);
-//                }
-//                catch (const beast::system_error& se) {
-//                    if (se.code() != beast::error::timeout) {
-//                        std::cerr << "Request handling error: " << se.what() << std::endl;
-//                    }
-//                }
-//                catch (const std::exception& e) {
-//                    std::cerr << "Request handling error: " << e.what() << std::endl;
-//                }
-//                }).detach();
-//        }
-//
-//        //   
-//        if (!stopped_ && !g_signal_received) {
-//            Listen();
-//        }
-//        });
-//}
+void HttpSession::DoClose() {
+    // Закрываем соединение
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+
+    if (ec && ec != beast::errc::not_connected) {
+        std::cerr << "Error shutting down socket: " << ec.message() << std::endl;
+    }
+}
 
 std::vector<std::string> BeastHttpServer::ParseSearchQuery(const std::string& query) {
     std::vector<std::string> words;
@@ -183,7 +882,7 @@ std::vector<std::string> BeastHttpServer::ParseSearchQuery(const std::string& qu
     std::string word;
 
     while (ss >> word) {
-        //          
+        // Очищаем слово от знаков препинания и приводим к нижнему регистру
         std::string clean_word;
         for (char c : word) {
             if (std::isalnum(c)) {
@@ -191,7 +890,7 @@ std::vector<std::string> BeastHttpServer::ParseSearchQuery(const std::string& qu
             }
         }
 
-        //    
+        // Добавляем только валидные слова
         if (clean_word.length() >= 3 && clean_word.length() <= 32) {
             words.push_back(clean_word);
         }
@@ -200,277 +899,689 @@ std::vector<std::string> BeastHttpServer::ParseSearchQuery(const std::string& qu
     return words;
 }
 
-void BeastHttpServer::HandleRequest(http::request<http::string_body>&& req,
-    std::shared_ptr<tcp::socket> socket) {
+std::string BeastHttpServer::UrlDecode(std::string_view value) {
+    auto hex_digit = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    std::string decoded;
+    decoded.reserve(value.size());
+
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '+') {
+            decoded += ' ';
+            continue;
+        }
+        if (value[i] == '%' && i + 2 < value.size()) {
+            int high = hex_digit(value[i + 1]);
+            int low = hex_digit(value[i + 2]);
+            if (high >= 0 && low >= 0) {
+                decoded += static_cast<char>((high << 4) | low);
+                i += 2;
+                continue;
+            }
+        }
+        decoded += value[i];
+    }
+
+    return decoded;
+}
+
+std::string BeastHttpServer::GetParameter(std::string_view params, std::string_view name) {
+    // params имеет вид "a=1&b=2" (строка запроса или тело формы)
+    while (!params.empty()) {
+        size_t amp_pos = params.find('&');
+        std::string_view pair = params.substr(0, amp_pos);
+
+        size_t eq_pos = pair.find('=');
+        if (pair.substr(0, eq_pos) == name) {
+            return eq_pos == std::string_view::npos ? std::string() : UrlDecode(pair.substr(eq_pos + 1));
+        }
+
+        if (amp_pos == std::string_view::npos) break;
+        params.remove_prefix(amp_pos + 1);
+    }
+
+    return {};
+}
+
+int BeastHttpServer::GetIntParameter(std::string_view params, std::string_view name, int default_value) {
+    std::string value = GetParameter(params, name);
+    if (value.empty()) return default_value;
+
+    try {
+        return std::stoi(value);
+    }
+    catch (const std::exception&) {
+        return default_value;
+    }
+}
+
+http::response<http::string_body> BeastHttpServer::MakeResponse(http::status status, unsigned version,
+    const char* content_type, std::string&& body) {
+    http::response<http::string_body> res{ status, version };
+    res.set(http::field::server, "SearchEngine/1.0");
+    res.set(http::field::content_type, content_type);
+    res.body() = std::move(body);
+    res.prepare_payload();
+    return res;
+}
+
+http::response<http::string_body> BeastHttpServer::HandleRequest(http::request<http::string_body>&& req,
+    const net::ip::address& client) {
+    auto start = std::chrono::steady_clock::now();
+    auto& metrics = Metrics::Instance();
+    // Запрос от начала до конца работает с одним снимком, даже если его уже подменили
+    auto state = state_.Load();
     http::response<http::string_body> res;
+    Route route = Route::Other;
+    std::optional<RequestTrace> trace;
 
     try {
-        if (req.method() == http::verb::get) {
-            //  GET  ( )
-            if (req.target() == "/" || req.target() == "/search") {
-                std::string query;
-
-                //     URL
-                size_t query_pos = req.target().find('?');
-                if (query_pos != std::string::npos) {
-                    std::string query_str = req.target().substr(query_pos + 1);
-                    size_t q_pos = query_str.find("q=");
-                    if (q_pos != std::string::npos) {
-                        query = query_str.substr(q_pos + 2);
-                        size_t amp_pos = query.find('&');
-                        if (amp_pos != std::string::npos) {
-                            query = query.substr(0, amp_pos);
-                        }
-
-                        // URL decode ( )
-                        std::string decoded_query;
-                        for (size_t i = 0; i < query.length(); ++i) {
-                            if (query[i] == '%' && i + 2 < query.length()) {
-                                int hex_value;
-                                std::stringstream hex_stream;
-                                hex_stream << std::hex << query.substr(i + 1, 2);
-                                hex_stream >> hex_value;
-                                decoded_query += static_cast<char>(static_cast<unsigned char>(hex_value));
-                                i += 2;
-                            }
-                            else {
-                                decoded_query += query[i];
-                            }
-                        }
-                        query = decoded_query;
-                    }
-                }
+        // Разделяем цель запроса на путь и строку параметров
+        std::string_view target(req.target().data(), req.target().size());
+        size_t query_pos = target.find('?');
+        std::string_view path = target.substr(0, query_pos);
+        std::string_view params = query_pos == std::string_view::npos ? std::string_view() : target.substr(query_pos + 1);
 
-                res = { http::status::ok, req.version() };
-                res.set(http::field::server, "SearchEngine/1.0");
-                res.set(http::field::content_type, "text/html");
-                res.body() = GenerateSearchPage(query);
-                res.prepare_payload();
+        // Трассировка активна только при включенном журнале медленных запросов
+        if (SlowQueryLog::Instance().Enabled()) {
+            trace.emplace(std::string(path));
+        }
+
+        if (path.substr(0, 7) == "/admin/") {
+            // Административные маршруты доступны только с локального адреса
+            if (client.is_loopback()) {
+                res = HandleAdmin(req, path, *state);
             }
             else {
-                // 404 Not Found
-                res = { http::status::not_found, req.version() };
-                res.set(http::field::server, "SearchEngine/1.0");
-                res.set(http::field::content_type, "text/html");
-                res.body() = GenerateErrorPage("Page not found");
-                res.prepare_payload();
+                res = MakeResponse(http::status::forbidden, req.version(), "text/html", GenerateErrorPage("Forbidden"));
             }
         }
-        else if (req.method() == http::verb::post && req.target() == "/search") {
-            //  POST  ()
-            std::string query;
-
-            //   
-            std::string body = req.body();
-            size_t pos = body.find("q=");
-            if (pos != std::string::npos) {
-                query = body.substr(pos + 2);
-                //  URL-encoded  ()
-                std::replace(query.begin(), query.end(), '+', ' ');
-                //    &
-                size_t amp_pos = query.find('&');
-                if (amp_pos != std::string::npos) {
-                    query = query.substr(0, amp_pos);
+        else if (req.method() == http::verb::get) {
+            // Обработка GET запроса (форма поиска)
+            if (path == "/" || path == "/search") {
+                route = Route::Landing;
+                std::string query = GetParameter(params, "q");
+                if (query.empty()) {
+                    res = state->landing_responses[static_cast<int>(SelectEncoding(req, *state))];
+                    res.version(req.version());
+                    metrics.Increment(metric_ids_.cache_hits);
                 }
-
-                // URL decode ( )
-                std::string decoded_query;
-                for (size_t i = 0; i < query.length(); ++i) {
-                    if (query[i] == '%' && i + 2 < query.length()) {
-                        int hex_value;
-                        std::stringstream hex_stream;
-                        hex_stream << std::hex << query.substr(i + 1, 2);
-                        hex_stream >> hex_value;
-                        decoded_query += static_cast<char>(static_cast<unsigned char>(hex_value));
-                        i += 2;
-                    }
-                    else {
-                        decoded_query += query[i];
-                    }
+                else if (path == "/search") {
+                    // GET-поиск можно кэшировать: форма отправляется этим методом
+                    route = Route::Search;
+                    res = HandleSearch(req, *state, params, true);
+                }
+                else {
+                    res = MakeResponse(http::status::ok, req.version(), "text/html", GenerateSearchPage(query));
+                    metrics.Increment(metric_ids_.cache_misses);
                 }
-                query = decoded_query;
             }
-
-            //   -    
-            auto words = ParseSearchQuery(query);
-            auto results = db_.SearchDocuments(words, config_.GetMaxResults());
-
-            res = { http::status::ok, req.version() };
-            res.set(http::field::server, "SearchEngine/1.0");
-            res.set(http::field::content_type, "text/html");
-            res.body() = GenerateResultsPage(results, query);
-            res.prepare_payload();
+            else if (path == "/api/search") {
+                route = Route::ApiSearch;
+                res = HandleApiSearch(req, *state, params);
+            }
+            else if (path == "/metrics") {
+                route = Route::Metrics;
+                res = MakeResponse(http::status::ok, req.version(), "text/plain; version=0.0.4", metrics.Render());
+            }
+            else if (path == "/debug/traces") {
+                // В трассах чужие запросы и внутренние тайминги: только локально, как /admin/
+                if (client.is_loopback()) {
+                    res = HandleDebugTraces(req, params);
+                }
+                else {
+                    res = MakeResponse(http::status::forbidden, req.version(), "text/html", GenerateErrorPage("Forbidden"));
+                }
+            }
+            else {
+                // 404 Not Found
+                res = MakeResponse(http::status::not_found, req.version(), "text/html", GenerateErrorPage("Page not found"));
+            }
+        }
+        else if (req.method() == http::verb::post && path == "/search") {
+            // Обработка POST запроса (поиск): тело формы application/x-www-form-urlencoded
+            route = Route::Search;
+            res = HandleSearch(req, *state, req.body(), false);
         }
         else {
             // 404 Not Found
-            res = { http::status::not_found, req.version() };
-            res.set(http::field::server, "SearchEngine/1.0");
-            res.set(http::field::content_type, "text/html");
-            res.body() = GenerateErrorPage("Page not found");
-            res.prepare_payload();
+            res = MakeResponse(http::status::not_found, req.version(), "text/html", GenerateErrorPage("Page not found"));
         }
     }
     catch (const std::exception& e) {
         std::cerr << "Error handling request: " << e.what() << std::endl;
-        res = { http::status::internal_server_error, req.version() };
-        res.set(http::field::server, "SearchEngine/1.0");
-        res.set(http::field::content_type, "text/html");
-        res.body() = GenerateErrorPage("Internal server error");
-        res.prepare_payload();
+        res = MakeResponse(http::status::internal_server_error, req.version(), "text/html",
+            GenerateErrorPage("Internal server error"));
+    }
+
+    {
+        TraceSpan compress_span("compress");
+        CompressResponse(req, *state, res);
+    }
+
+    if (trace) {
+        SlowQueryLog::Instance().Record(*trace);
     }
 
-    //  
-    SendResponse(socket, std::move(res));
+    int route_index = static_cast<int>(route);
+    metrics.Increment(metric_ids_.requests[route_index]);
+    metrics.Observe(metric_ids_.latency[route_index],
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return res;
 }
 
-void BeastHttpServer::SendResponse(std::shared_ptr<tcp::socket> socket,
-    http::response<http::string_body>&& response) {
-    try {
-        http::write(*socket, response);
+http::response<http::string_body> BeastHttpServer::HandleDebugTraces(const http::request<http::string_body>& req,
+    std::string_view params) {
+    int count = std::max(GetIntParameter(params, "n", config_.GetTraceBufferSize()), 0);
+    auto entries = SlowQueryLog::Instance().Recent(static_cast<size_t>(count));
+
+    std::string body;
+    JsonWriter json(body);
+    json.BeginObject();
+    json.Field("threshold_ms", config_.GetSlowQueryMs());
+    json.Key("traces");
+    json.BeginArray();
+
+    // Самые свежие запросы первыми
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        json.BeginObject();
+        json.Field("time", static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            it->time.time_since_epoch()).count()));
+        json.Field("route", it->route);
+        json.Field("total_ms", it->total_us / 1000.0);
 
-        //  
-        beast::error_code ec;
-        socket->shutdown(tcp::socket::shutdown_send, ec);
+        json.Key("terms");
+        json.BeginArray();
+        for (const auto& term : it->terms) {
+            json.String(term);
+        }
+        json.EndArray();
 
-        if (ec && ec != beast::errc::not_connected) {
-            std::cerr << "Error shutting down socket: " << ec.message() << std::endl;
+        json.Key("spans");
+        json.BeginArray();
+        for (const auto& span : it->spans) {
+            json.BeginObject();
+            json.Field("name", span.name);
+            json.Field("start_ms", span.start_us / 1000.0);
+            json.Field("duration_ms", span.duration_us / 1000.0);
+            json.EndObject();
         }
+        json.EndArray();
+
+        json.Field("summary", SlowQueryLog::Format(*it));
+        json.EndObject();
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error sending response: " << e.what() << std::endl;
+
+    json.EndArray();
+    json.EndObject();
+
+    return MakeResponse(http::status::ok, req.version(), "application/json; charset=utf-8", std::move(body));
+}
+
+http::response<http::string_body> BeastHttpServer::HandleAdmin(const http::request<http::string_body>& req,
+    std::string_view path, const ServingState& state) {
+    std::string body;
+    JsonWriter json(body);
+
+    if (req.method() == http::verb::post && path == "/admin/reload") {
+        // Снимок собирается в фоновом потоке, ответ не ждет его готовности
+        g_reload_requested = true;
+        json.BeginObject();
+        json.Field("status", "scheduled");
+        json.Field("version", static_cast<int64_t>(state.version));
+        json.EndObject();
+        return MakeResponse(http::status::accepted, req.version(), "application/json; charset=utf-8", std::move(body));
+    }
+
+    if (req.method() == http::verb::get && path == "/admin/state") {
+        json.BeginObject();
+        json.Field("version", static_cast<int64_t>(state.version));
+        json.Field("loaded_at", static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            state.loaded_at.time_since_epoch()).count()));
+        json.Field("generation", static_cast<int64_t>(state.index.generation));
+        json.Field("documents", static_cast<int64_t>(state.index.documents));
+        json.Field("words", static_cast<int64_t>(state.index.words));
+        json.Field("max_results", state.max_results);
+        json.Field("api_max_limit", state.api_max_limit);
+        json.Field("compression", state.compression_enabled);
+        json.Field("cache_control", state.cache_control);
+        json.EndObject();
+        return MakeResponse(http::status::ok, req.version(), "application/json; charset=utf-8", std::move(body));
+    }
+
+    return MakeResponse(http::status::not_found, req.version(), "text/html", GenerateErrorPage("Page not found"));
+}
+
+http::response<http::string_body> BeastHttpServer::MakeOverloadResponse(const http::request<http::string_body>& req) {
+    auto res = MakeResponse(http::status::service_unavailable, req.version(), "text/html",
+        GenerateErrorPage("Server is busy, please retry later"));
+    res.set(http::field::retry_after, std::to_string(config_.GetRetryAfter()));
+    return res;
+}
+
+ContentEncoding BeastHttpServer::SelectEncoding(const http::request<http::string_body>& req,
+    const ServingState& state) {
+    if (!state.compression_enabled) {
+        return ContentEncoding::Identity;
+    }
+
+    auto accept_encoding = req[http::field::accept_encoding];
+    return NegotiateEncoding(std::string_view(accept_encoding.data(), accept_encoding.size()));
+}
+
+void BeastHttpServer::CompressResponse(const http::request<http::string_body>& req, const ServingState& state,
+    http::response<http::string_body>& res) {
+    // Уже сжатые (предварительно подготовленные) ответы и маленькие тела не трогаем
+    if (!state.compression_enabled || res.count(http::field::content_encoding) > 0) {
+        return;
+    }
+    if (res.body().size() < static_cast<size_t>(state.compression_min_size)) {
+        return;
+    }
+
+    res.set(http::field::vary, "Accept-Encoding");
+
+    ContentEncoding encoding = SelectEncoding(req, state);
+    if (encoding == ContentEncoding::Identity) {
+        return;
+    }
+
+    std::string compressed;
+    auto& compressor = Compressor::ForThread(encoding, state.compression_level);
+    if (!compressor.Compress(res.body(), compressed) || compressed.size() >= res.body().size()) {
+        return;
+    }
+
+    res.body() = std::move(compressed);
+    res.set(http::field::content_encoding, EncodingName(encoding));
+    res.prepare_payload();
+}
+
+http::response<http::string_body> BeastHttpServer::HandleSearch(const http::request<http::string_body>& req,
+    const ServingState& state, std::string_view params, bool cacheable) {
+    std::string query = GetParameter(params, "q");
+    int limit = state.max_results;
+
+    std::vector<std::string> words;
+    {
+        TraceSpan parse_span("parse");
+        words = ParseSearchQuery(query);
+    }
+
+    // Повтор запроса при неизменном индексе получает 304 без обращения к базе
+    std::string etag;
+    if (cacheable) {
+        etag = MakeETag(state, "html", words, limit, 0, SelectEncoding(req, state));
+        if (!etag.empty() && ETagMatches(req, etag)) {
+            return MakeNotModified(req, state, etag);
+        }
+    }
+    if (auto* trace = RequestTrace::Current()) {
+        trace->SetTerms(words);
+    }
+
+    // Выполняем поиск - используем нашу функцию парсинга
+    auto budget = SearchBudget::After(SearchBudgetMs(state, params));
+    auto results = db_.SearchDocuments(words, limit, 0, nullptr, &budget);
+    if (budget.partial) {
+        Metrics::Instance().Increment(metric_ids_.partial_results);
+    }
+
+    Metrics::Timer render_timer(metric_ids_.render_seconds);
+    TraceSpan render_span("render");
+    auto res = MakeResponse(http::status::ok, req.version(), "text/html",
+        GenerateResultsPage(results, query, budget.partial));
+    // Неполные результаты не кэшируем
+    if (!etag.empty() && !budget.partial) {
+        SetCacheHeaders(res, state, etag);
+    }
+    return res;
+}
+
+int BeastHttpServer::SearchBudgetMs(const ServingState& state, std::string_view params) {
+    // Запрос может только сократить глобальный бюджет (или задать свой, если глобального нет)
+    int budget_ms = state.search_timeout_ms;
+    int requested = GetIntParameter(params, "budget_ms", 0);
+    if (requested > 0 && (budget_ms <= 0 || requested < budget_ms)) {
+        budget_ms = requested;
+    }
+    return budget_ms;
+}
+
+std::string BeastHttpServer::MakeETag(const ServingState& state, std::string_view kind,
+    const std::vector<std::string>& terms, int limit, int offset, ContentEncoding encoding) {
+    long long generation = state.index.generation;
+    if (generation < 0) {
+        return std::string();
+    }
+
+    // FNV-1a по всему, от чего зависит выдача. Запрос входит списком слов, по которому
+    // ищет база, поэтому регистр, лишние пробелы и знаки препинания ETag не меняют.
+    // Исходный текст запроса тело повторяет, но он задан самим URL, а ETag сравнивается
+    // только в пределах одного URL.
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](std::string_view data) {
+        for (unsigned char c : data) {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+        hash = (hash ^ 0xff) * 1099511628211ull;
+    };
+
+    char buf[24];
+    mix(kind);
+    for (const auto& term : terms) {
+        mix(term);
+    }
+    mix({});    // конец списка слов
+    mix(FormatInt(buf, limit));
+    mix(FormatInt(buf, offset));
+    mix(EncodingName(encoding));
+
+    // Сильный ETag: "<поколение>-<хэш>", оба числа в шестнадцатеричном виде
+    char etag[48];
+    char* p = etag;
+    *p++ = '"';
+    p = std::to_chars(p, etag + sizeof(etag), generation, 16).ptr;
+    *p++ = '-';
+    p = std::to_chars(p, etag + sizeof(etag), hash, 16).ptr;
+    *p++ = '"';
+    return std::string(etag, p);
+}
+
+bool BeastHttpServer::ETagMatches(const http::request<http::string_body>& req, std::string_view etag) {
+    auto header = req[http::field::if_none_match];
+    std::string_view list(header.data(), header.size());
+
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+
+        if (item == "*") {
+            return true;
+        }
+        // If-None-Match сравнивает слабо: префикс W/ не учитывается
+        if (item.substr(0, 2) == "W/") {
+            item.remove_prefix(2);
+        }
+        if (item == etag) {
+            return true;
+        }
     }
+    return false;
+}
+
+http::response<http::string_body> BeastHttpServer::MakeNotModified(const http::request<http::string_body>& req,
+    const ServingState& state, const std::string& etag) {
+    Metrics::Instance().Increment(metric_ids_.cache_hits);
+
+    http::response<http::string_body> res{ http::status::not_modified, req.version() };
+    res.set(http::field::server, "SearchEngine/1.0");
+    SetCacheHeaders(res, state, etag);
+    return res;
+}
+
+void BeastHttpServer::SetCacheHeaders(http::response<http::string_body>& res, const ServingState& state,
+    const std::string& etag) {
+    res.set(http::field::etag, etag);
+    res.set(http::field::vary, "Accept-Encoding");
+    if (!state.cache_control.empty()) {
+        res.set(http::field::cache_control, state.cache_control);
+    }
+}
+
+bool BeastHttpServer::IsBatchRequest(const http::request<http::string_body>& req) {
+    std::string_view target(req.target().data(), req.target().size());
+    return req.method() == http::verb::post && target.substr(0, target.find('?')) == "/api/search/batch";
+}
+
+bool BeastHttpServer::PrepareBatch(const http::request<http::string_body>& req, const ServingState& state,
+    BatchPlan& plan, http::response<http::string_body>& error) {
+    if (!ParseJsonStringArray(req.body(), plan.queries) || plan.queries.empty()) {
+        error = MakeResponse(http::status::bad_request, req.version(), "application/json; charset=utf-8",
+            "{\"error\":\"body must be a non-empty JSON array of query strings\"}");
+        return false;
+    }
+    if (plan.queries.size() > static_cast<size_t>(std::max(config_.GetBatchMaxQueries(), 1))) {
+        error = MakeResponse(http::status::payload_too_large, req.version(), "application/json; charset=utf-8",
+            "{\"error\":\"too many queries in batch\"}");
+        return false;
+    }
+
+    std::string_view target(req.target().data(), req.target().size());
+    size_t query_pos = target.find('?');
+    std::string_view params = query_pos == std::string_view::npos ? std::string_view() : target.substr(query_pos + 1);
+    plan.limit = std::clamp(GetIntParameter(params, "limit", state.max_results), 1, state.api_max_limit);
+    plan.budget_ms = SearchBudgetMs(state, params);
+
+    // Одинаковые термы разных запросов разрешаются в id одним обращением к базе
+    std::vector<std::string> unique_words;
+    std::unordered_set<std::string> seen;
+    plan.words.reserve(plan.queries.size());
+    for (const auto& query : plan.queries) {
+        plan.words.push_back(ParseSearchQuery(query));
+        for (const auto& word : plan.words.back()) {
+            if (seen.insert(word).second) {
+                unique_words.push_back(word);
+            }
+        }
+    }
+    auto word_ids = db_.ResolveWordIds(unique_words);
+
+    plan.word_ids.resize(plan.queries.size());
+    for (size_t i = 0; i < plan.queries.size(); ++i) {
+        auto& ids = plan.word_ids[i];
+        for (const auto& word : plan.words[i]) {
+            auto it = word_ids.find(word);
+            if (it == word_ids.end()) {
+                // Слова нет в индексе: документов со всеми словами запроса тоже нет
+                ids.clear();
+                break;
+            }
+            ids.push_back(it->second);
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+    return true;
+}
+
+std::string BeastHttpServer::RunBatchQuery(const BatchPlan& plan, size_t index) {
+    std::vector<SearchResult> results;
+    // Бюджет у каждого запроса пакета свой и отсчитывается от начала его выполнения
+    auto budget = SearchBudget::After(plan.budget_ms);
+    if (!plan.word_ids[index].empty()) {
+        results = db_.SearchDocumentsByIds(plan.word_ids[index], plan.words[index], plan.limit, 0, nullptr, &budget);
+    }
+    if (budget.partial) {
+        Metrics::Instance().Increment(metric_ids_.partial_results);
+    }
+
+    std::string line;
+    JsonWriter json(line);
+    json.BeginObject();
+    json.Field("index", static_cast<int64_t>(index));
+    json.Field("query", plan.queries[index]);
+
+    json.Key("terms");
+    json.BeginArray();
+    for (const auto& word : plan.words[index]) {
+        json.String(word);
+    }
+    json.EndArray();
+
+    json.Field("count", static_cast<int64_t>(results.size()));
+    json.Field("partial", budget.partial);
+    json.Key("results");
+    json.BeginArray();
+    for (const auto& result : results) {
+        json.BeginObject();
+        json.Field("url", result.url);
+        json.Field("title", result.title.empty() ? result.url : result.title);
+        json.Field("snippet", result.snippet);
+        json.Field("relevance", result.relevance);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+
+    line += '\n';
+    return line;
+}
+
+http::response<http::string_body> BeastHttpServer::HandleApiSearch(const http::request<http::string_body>& req,
+    const ServingState& state, std::string_view params) {
+    using clock = std::chrono::steady_clock;
+    auto ms_since = [](clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    };
+
+    auto parse_start = clock::now();
+    std::string query = GetParameter(params, "q");
+    int limit = std::clamp(GetIntParameter(params, "limit", state.max_results), 1, state.api_max_limit);
+    int offset = std::max(GetIntParameter(params, "offset", 0), 0);
+    bool debug = GetParameter(params, "debug") == "1";
+    auto words = ParseSearchQuery(query);
+    double parse_ms = ms_since(parse_start);
+
+    // Отладочные ответы содержат замеры времени и не кэшируются
+    std::string etag;
+    if (!debug) {
+        etag = MakeETag(state, "json", words, limit, offset, SelectEncoding(req, state));
+        if (!etag.empty() && ETagMatches(req, etag)) {
+            return MakeNotModified(req, state, etag);
+        }
+    }
+
+    if (auto* trace = RequestTrace::Current()) {
+        trace->AddSpan("parse", parse_start, clock::now());
+        trace->SetTerms(words);
+    }
+
+    SearchTimings timings;
+    auto budget = SearchBudget::After(SearchBudgetMs(state, params));
+    auto results = db_.SearchDocuments(words, limit, offset, &timings, &budget);
+    if (budget.partial) {
+        Metrics::Instance().Increment(metric_ids_.partial_results);
+    }
+
+    auto serialize_start = clock::now();
+    Metrics::Timer render_timer(metric_ids_.render_seconds);
+    TraceSpan serialize_span("serialize");
+
+    // Оценка размера ответа, чтобы буфер не перевыделялся во время записи
+    std::string body;
+    size_t estimate = 256 + query.size();
+    for (const auto& result : results) {
+        estimate += 96 + result.url.size() + result.title.size() + result.snippet.size();
+    }
+    body.reserve(estimate);
+
+    JsonWriter json(body);
+    json.BeginObject();
+    json.Field("query", query);
+
+    json.Key("terms");
+    json.BeginArray();
+    for (const auto& word : words) {
+        json.String(word);
+    }
+    json.EndArray();
+
+    json.Field("limit", limit);
+    json.Field("offset", offset);
+    json.Field("count", static_cast<int64_t>(results.size()));
+    json.Field("partial", budget.partial);
+
+    json.Key("results");
+    json.BeginArray();
+    for (const auto& result : results) {
+        json.BeginObject();
+        json.Field("url", result.url);
+        json.Field("title", result.title.empty() ? result.url : result.title);
+        json.Field("snippet", result.snippet);
+        json.Field("relevance", result.relevance);
+        json.EndObject();
+    }
+    json.EndArray();
+
+    if (debug) {
+        // Время сериализации измеряется до этого места: оставшиеся байты пренебрежимо малы
+        json.Key("timings");
+        json.BeginObject();
+        json.Field("parse_ms", parse_ms);
+        json.Field("retrieve_ms", timings.retrieve_ms);
+        json.Field("snippet_ms", timings.snippet_ms);
+        json.Field("serialize_ms", ms_since(serialize_start));
+        json.EndObject();
+    }
+
+    json.EndObject();
+
+    auto res = MakeResponse(http::status::ok, req.version(), "application/json; charset=utf-8", std::move(body));
+    // Неполные результаты не кэшируем
+    if (!etag.empty() && !budget.partial) {
+        SetCacheHeaders(res, state, etag);
+    }
+    return res;
 }
 
 std::string BeastHttpServer::GenerateSearchPage(const std::string& query) {
-    std::stringstream html;
-    html << "<!DOCTYPE html>"
-        << "<html>"
-        << "<head>"
-        << "<title>Search Engine</title>"
-        << "<meta charset='UTF-8'>"
-        << "<meta name='viewport' content='width=device-width, initial-scale=1.0'>"
-        << "<style>"
-        << "body { font-family: Arial, sans-serif; margin: 40px; background-color: #f5f5f5; }"
-        << ".container { max-width: 800px; margin: 0 auto; background: white; padding: 30px; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }"
-        << ".search-box { text-align: center; margin-bottom: 30px; }"
-        << "h1 { color: #4285f4; margin-bottom: 30px; }"
-        << "input[type=text] { width: 70%; padding: 12px; font-size: 16px; border: 1px solid #ddd; border-radius: 24px; outline: none; }"
-        << "input[type=text]:focus { border-color: #4285f4; box-shadow: 0 0 5px rgba(66, 133, 244, 0.3); }"
-        << "input[type=submit] { padding: 12px 24px; font-size: 16px; background-color: #4285f4; color: white; border: none; border-radius: 24px; cursor: pointer; margin-left: 10px; }"
-        << "input[type=submit]:hover { background-color: #3367d6; }"
-        << ".footer { text-align: center; margin-top: 40px; color: #666; font-size: 14px; }"
-        << "</style>"
-        << "</head>"
-        << "<body>"
-        << "<div class='container'>"
-        << "<div class='search-box'>"
-        << "<h1>Search Engine</h1>"
-        << "<form method='post' action='/search'>"
-        << "<input type='text' name='q' value='" << query << "' placeholder='Enter your search query...'>"
-        << "<input type='submit' value='Search'>"
-        << "</form>"
-        << "</div>"
-        << "<div class='footer'>"
-        << "Built with C++, Boost.Beast and PostgreSQL"
-        << "</div>"
-        << "</div>"
-        << "</body>"
-        << "</html>";
-    return html.str();
-}
-
-std::string BeastHttpServer::GenerateResultsPage(const std::vector<SearchResult>& results, const std::string& query) {
-    std::stringstream html;
-    html << "<!DOCTYPE html>"
-        << "<html>"
-        << "<head>"
-        << "<title>Search Results for \"" << query << "\"</title>"
-        << "<meta charset='UTF-8'>"
-        << "<meta name='viewport' content='width=device-width, initial-scale=1.0'>"
-        << "<style>"
-        << "body { font-family: Arial, sans-serif; margin: 0; padding: 0; background-color: #f5f5f5; }"
-        << ".header { background: white; padding: 20px; border-bottom: 1px solid #e0e0e0; }"
-        << ".container { max-width: 800px; margin: 0 auto; }"
-        << ".search-box { display: flex; align-items: center; }"
-        << "h1 { color: #4285f4; margin: 0; margin-right: 30px; font-size: 24px; }"
-        << "input[type=text] { flex: 1; padding: 12px; font-size: 16px; border: 1px solid #ddd; border-radius: 24px; outline: none; }"
-        << "input[type=text]:focus { border-color: #4285f4; }"
-        << "input[type=submit] { padding: 12px 24px; font-size: 16px; background-color: #4285f4; color: white; border: none; border-radius: 24px; cursor: pointer; margin-left: 10px; }"
-        << ".results { background: white; margin: 20px auto; max-width: 800px; padding: 20px; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }"
-        << ".result { margin-bottom: 25px; padding-bottom: 20px; border-bottom: 1px solid #f0f0f0; }"
-        << ".result:last-child { border-bottom: none; margin-bottom: 0; }"
-        << ".result-title { font-size: 18px; color: #1a0dab; text-decoration: none; font-weight: normal; margin: 0 0 5px 0; display: block; }"
-        << ".result-title:hover { text-decoration: underline; }"
-        << ".result-url { color: #006621; font-size: 14px; margin: 0 0 8px 0; }"
-        << ".result-snippet { color: #545454; font-size: 14px; line-height: 1.4; margin: 0; }"
-        << ".result-relevance { color: #70757a; font-size: 12px; margin-top: 5px; }"
-        << ".no-results { text-align: center; padding: 40px; color: #70757a; }"
-        << ".results-count { color: #70757a; font-size: 14px; margin-bottom: 20px; }"
-        << "</style>"
-        << "</head>"
-        << "<body>"
-        << "<div class='header'>"
-        << "<div class='container'>"
-        << "<div class='search-box'>"
-        << "<h1>Search Engine</h1>"
-        << "<form method='post' action='/search' style='display: flex; flex: 1;'>"
-        << "<input type='text' name='q' value='" << query << "'>"
-        << "<input type='submit' value='Search'>"
-        << "</form>"
-        << "</div>"
-        << "</div>"
-        << "</div>"
-        << "<div class='results'>"
-        << "<div class='results-count'>Found " << results.size() << " results for \"" << query << "\"</div>";
+    std::string html;
+    html.reserve(search_page_template_.StaticSize() + query.size() * 2);
+    search_page_template_.Render(html, { query });
+    return html;
+}
+
+std::string BeastHttpServer::GenerateResultsPage(const std::vector<SearchResult>& results, const std::string& query,
+    bool partial) {
+    // Оцениваем итоговый размер, чтобы рендеринг шел в один заранее выделенный буфер
+    size_t estimate = results_header_template_.StaticSize() + query.size() * 3 +
+        sizeof(kNoResultsHtml) + sizeof(kPartialResultsHtml) + sizeof(kResultsFooterHtml) + 32;
+    for (const auto& result : results) {
+        estimate += result_item_template_.StaticSize() + result.url.size() * 2 +
+            result.title.size() + result.snippet.size() + 16;
+    }
+
+    std::string html;
+    html.reserve(estimate + estimate / 8);
+
+    char count_buf[24];
+    results_header_template_.Render(html, { query, FormatInt(count_buf, static_cast<long long>(results.size())) });
+    if (partial) {
+        html += kPartialResultsHtml;
+    }
 
     if (results.empty()) {
-        html << "<div class='no-results'>"
-            << "<h3>No results found</h3>"
-            << "<p>Try different keywords or check your spelling.</p>"
-            << "</div>";
+        html += kNoResultsHtml;
     }
     else {
         for (const auto& result : results) {
-            html << "<div class='result'>"
-                << "<a class='result-title' href='" << result.url << "' target='_blank'>"
-                << (result.title.empty() ? result.url : result.title)
-                << "</a>"
-                << "<div class='result-url'>" << result.url << "</div>"
-                << "<div class='result-snippet'>" << result.snippet << "</div>"
-                << "<div class='result-relevance'>Relevance score: " << result.relevance << "</div>"
-                << "</div>";
+            char relevance_buf[24];
+            result_item_template_.Render(html, {
+                result.url,
+                result.title.empty() ? result.url : result.title,
+                result.snippet,
+                FormatInt(relevance_buf, result.relevance)
+                });
         }
     }
 
-    html << "</div>"
-        << "</body>"
-        << "</html>";
-    return html.str();
+    html += kResultsFooterHtml;
+    return html;
 }
 
 std::string BeastHttpServer::GenerateErrorPage(const std::string& message) {
-    std::stringstream html;
-    html << "<!DOCTYPE html>"
-        << "<html>"
-        << "<head>"
-        << "<title>Error</title>"
-        << "<meta charset='UTF-8'>"
-        << "<meta name='viewport' content='width=device-width, initial-scale=1.0'>"
-        << "<style>"
-        << "body { font-family: Arial, sans-serif; margin: 40px; background-color: #f5f5f5; }"
-        << ".container { max-width: 600px; margin: 0 auto; background: white; padding: 30px; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); text-align: center; }"
-        << ".error { color: #d93025; font-size: 18px; margin-bottom: 20px; }"
-        << "a { color: #4285f4; text-decoration: none; }"
-        << "a:hover { text-decoration: underline; }"
-        << "</style>"
-        << "</head>"
-        << "<body>"
-        << "<div class='container'>"
-        << "<h1>Error</h1>"
-        << "<div class='error'>" << message << "</div>"
-        << "<p><a href='/'>Back to search</a></p>"
-        << "</div>"
-        << "</body>"
-        << "</html>";
-    return html.str();
+    std::string html;
+    html.reserve(error_page_template_.StaticSize() + message.size() * 2);
+    error_page_template_.Render(html, { message });
+    return html;
 }
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "compression.h"
+#include <algorithm>
+#include <memory>
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+
+// Значение q для кодировки в Accept-Encoding: -1 если кодировка не указана
+double EncodingQuality(std::string_view header, std::string_view name) {
+    double wildcard = -1.0;
+
+    while (!header.empty()) {
+        size_t comma = header.find(',');
+        std::string_view item = header.substr(0, comma);
+        header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+
+        size_t semicolon = item.find(';');
+        std::string_view token = item.substr(0, semicolon);
+        while (!token.empty() && std::isspace(static_cast<unsigned char>(token.front()))) token.remove_prefix(1);
+        while (!token.empty() && std::isspace(static_cast<unsigned char>(token.back()))) token.remove_suffix(1);
+
+        double quality = 1.0;
+        if (semicolon != std::string_view::npos) {
+            std::string_view param = item.substr(semicolon + 1);
+            size_t q_pos = param.find("q=");
+            if (q_pos != std::string_view::npos) {
+                quality = std::atof(std::string(param.substr(q_pos + 2)).c_str());
+            }
+        }
+
+        bool matches = token.size() == name.size();
+        for (size_t i = 0; matches && i < token.size(); ++i) {
+            matches = std::tolower(static_cast<unsigned char>(token[i])) == name[i];
+        }
+
+        if (matches) return quality;
+        if (token == "*") wildcard = quality;
+    }
+
+    return wildcard;
+}
+
+} // namespace
+
+ContentEncoding NegotiateEncoding(std::string_view accept_encoding) {
+    if (accept_encoding.empty()) {
+        return ContentEncoding::Identity;
+    }
+
+    double gzip = EncodingQuality(accept_encoding, "gzip");
+    double deflate = EncodingQuality(accept_encoding, "deflate");
+
+    if (gzip > 0.0 && gzip >= deflate) return ContentEncoding::Gzip;
+    if (deflate > 0.0) return ContentEncoding::Deflate;
+    return ContentEncoding::Identity;
+}
+
+bool ParseContentEncoding(std::string_view content_encoding, ContentEncoding& encoding) {
+    std::string token;
+    for (char c : content_encoding) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            token += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+
+    if (token.empty() || token == "identity") {
+        encoding = ContentEncoding::Identity;
+    }
+    else if (token == "gzip" || token == "x-gzip") {
+        encoding = ContentEncoding::Gzip;
+    }
+    else if (token == "deflate") {
+        encoding = ContentEncoding::Deflate;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+const char* EncodingName(ContentEncoding encoding) {
+    switch (encoding) {
+    case ContentEncoding::Gzip: return "gzip";
+    case ContentEncoding::Deflate: return "deflate";
+    default: return "identity";
+    }
+}
+
+Compressor::Compressor(ContentEncoding encoding, int level)
+    : encoding_(encoding), level_(level) {
+    // 15 бит окна: +16 дает обертку gzip, без добавки - zlib (HTTP "deflate")
+    int window_bits = encoding == ContentEncoding::Gzip ? 15 + 16 : 15;
+    initialized_ = deflateInit2(&stream_, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+Compressor::~Compressor() {
+    if (initialized_) {
+        deflateEnd(&stream_);
+    }
+}
+
+bool Compressor::Compress(std::string_view input, std::string& output) {
+    if (!initialized_ || encoding_ == ContentEncoding::Identity) {
+        return false;
+    }
+
+    if (deflateReset(&stream_) != Z_OK) {
+        return false;
+    }
+
+    output.resize(deflateBound(&stream_, static_cast<uLong>(input.size())));
+
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream_.avail_in = static_cast<uInt>(input.size());
+    stream_.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream_.avail_out = static_cast<uInt>(output.size());
+
+    // deflateBound гарантирует, что весь вывод поместится за один вызов
+    int ret = deflate(&stream_, Z_FINISH);
+    if (ret != Z_STREAM_END) {
+        output.clear();
+        return false;
+    }
+
+    output.resize(stream_.total_out);
+    return true;
+}
+
+Compressor& Compressor::ForThread(ContentEncoding encoding, int level) {
+    thread_local std::unique_ptr<Compressor> compressors[3];
+
+    auto& compressor = compressors[static_cast<int>(encoding)];
+    if (!compressor || compressor->level_ != level) {
+        compressor = std::make_unique<Compressor>(encoding, level);
+    }
+    return *compressor;
+}
+
+Decompressor::Decompressor(size_t max_output) : max_output_(max_output) {
+    // 15 + 32: zlib сам различает обертки gzip и zlib по заголовку
+    initialized_ = inflateInit2(&stream_, 15 + 32) == Z_OK;
+}
+
+Decompressor::~Decompressor() {
+    if (initialized_) {
+        inflateEnd(&stream_);
+    }
+}
+
+bool Decompressor::Reset(ContentEncoding encoding) {
+    encoding_ = encoding;
+    started_ = false;
+    finished_ = false;
+    limit_exceeded_ = false;
+    return initialized_ && inflateReset2(&stream_, 15 + 32) == Z_OK;
+}
+
+bool Decompressor::Feed(std::string_view input, std::string& output) {
+    if (!initialized_ || limit_exceeded_) {
+        return false;
+    }
+    if (finished_ || input.empty()) {
+        // Данные после конца потока (например, выравнивание) не нужны
+        return true;
+    }
+
+    if (!started_) {
+        started_ = true;
+        // HTTP "deflate" по стандарту - поток zlib, но часть серверов шлет
+        // голый deflate без заголовка. Заголовок zlib: метод 8 и CMF*256+FLG кратно 31
+        if (encoding_ == ContentEncoding::Deflate && input.size() >= 2) {
+            unsigned cmf = static_cast<unsigned char>(input[0]);
+            unsigned flg = static_cast<unsigned char>(input[1]);
+            if ((cmf & 0x0F) != 8 || (cmf * 256 + flg) % 31 != 0) {
+                if (inflateReset2(&stream_, -15) != Z_OK) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream_.avail_in = static_cast<uInt>(input.size());
+
+    // Вывод может заполниться раньше, чем кончится вход, или zlib может
+    // придержать часть вывода: крутимся, пока есть вход или место кончилось
+    do {
+        // Растим вывод кусками, но не дальше предела плюс один байт: его
+        // хватает, чтобы заметить превышение
+        const size_t used = output.size();
+        if (used > max_output_) {
+            limit_exceeded_ = true;
+            return false;
+        }
+        const size_t room = std::min<size_t>(std::max<size_t>(input.size() * 4, 16384), max_output_ - used + 1);
+        output.resize(used + room);
+
+        stream_.next_out = reinterpret_cast<Bytef*>(&output[used]);
+        stream_.avail_out = static_cast<uInt>(room);
+        int ret = inflate(&stream_, Z_NO_FLUSH);
+        output.resize(used + room - stream_.avail_out);
+
+        if (ret == Z_STREAM_END) {
+            finished_ = true;
+            break;
+        }
+        // Z_BUF_ERROR - вход кончился посреди блока, ждем следующий кусок
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            return false;
+        }
+    } while (stream_.avail_in > 0 || stream_.avail_out == 0);
+
+    if (output.size() > max_output_) {
+        limit_exceeded_ = true;
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -3,12 +3,21 @@
 #include <sstream>
 #include <iostream>
 
+namespace {
+
+bool ParseBool(const std::string& value) {
+    return value == "true" || value == "1" || value == "yes" || value == "on";
+}
+
+} // namespace
+
 bool Config::Load(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Cannot open config file: " << filename << std::endl;
         return false;
     }
+    filename_ = filename;
 
     std::string line;
     std::string current_section;
@@ -51,6 +60,7 @@ bool Config::Load(const std::string& filename) {
                 else if (key == "dbname") db_name_ = value;
                 else if (key == "user") db_user_ = value;
                 else if (key == "password") db_password_ = value;
+                else if (key == "read_pool_size") db_read_pool_size_ = std::stoi(value);
             }
             else if (current_section == "spider") {
                 if (key == "start_url") start_url_ = value;
@@ -59,12 +69,59 @@ bool Config::Load(const std::string& filename) {
                 else if (key == "request_timeout") request_timeout_ = std::stoi(value);
                 else if (key == "user_agent") user_agent_ = value;
                 else if (key == "delay_between_requests") delay_between_requests_ = std::stoi(value);
+                else if (key == "metrics_file") metrics_file_ = value;
+                else if (key == "metrics_dump_interval") metrics_dump_interval_ = std::stoi(value);
+                else if (key == "max_concurrent_fetches") max_concurrent_fetches_ = std::stoi(value);
+                else if (key == "fetch_threads") fetch_threads_ = std::stoi(value);
+                else if (key == "dns_ttl") dns_ttl_ = std::stoi(value);
+                else if (key == "dns_negative_ttl") dns_negative_ttl_ = std::stoi(value);
+                else if (key == "pool_max_idle_per_host") pool_max_idle_per_host_ = std::stoi(value);
+                else if (key == "pool_idle_timeout") pool_idle_timeout_ = std::stoi(value);
+                else if (key == "respect_crawl_delay") respect_crawl_delay_ = ParseBool(value);
+                else if (key == "max_crawl_delay") max_crawl_delay_ = std::stoi(value);
+                else if (key == "frontier_memory_urls") frontier_memory_urls_ = std::stoi(value);
+                else if (key == "frontier_segment_urls") frontier_segment_urls_ = std::stoi(value);
+                else if (key == "frontier_dir") frontier_dir_ = value;
+                else if (key == "seen_expected_urls") seen_expected_urls_ = std::stoi(value);
+                else if (key == "seen_bloom") seen_bloom_ = ParseBool(value);
+                else if (key == "checkpoint_file") checkpoint_file_ = value;
+                else if (key == "checkpoint_interval") checkpoint_interval_ = std::stoi(value);
+                else if (key == "conditional_recrawl") conditional_recrawl_ = ParseBool(value);
+                else if (key == "max_decompressed_size") max_decompressed_size_ = std::stoi(value);
+                else if (key == "max_page_size") max_page_size_ = std::stoi(value);
             }
             else if (current_section == "search_server") {
                 if (key == "port") server_port_ = std::stoi(value);
                 else if (key == "max_results") max_results_ = std::stoi(value);
                 else if (key == "host") server_host_ = value;
                 else if (key == "threads") server_threads_ = std::stoi(value);
+                else if (key == "reuse_port") reuse_port_ = ParseBool(value);
+                else if (key == "pin_threads") pin_threads_ = ParseBool(value);
+                else if (key == "keep_alive_timeout") keep_alive_timeout_ = std::stoi(value);
+                else if (key == "max_keep_alive_requests") max_keep_alive_requests_ = std::stoi(value);
+                else if (key == "api_max_limit") api_max_limit_ = std::stoi(value);
+                else if (key == "compression") compression_enabled_ = ParseBool(value);
+                else if (key == "compression_level") compression_level_ = std::stoi(value);
+                else if (key == "compression_min_size") compression_min_size_ = std::stoi(value);
+                else if (key == "max_in_flight") max_in_flight_ = std::stoi(value);
+                else if (key == "max_queue_depth") max_queue_depth_ = std::stoi(value);
+                else if (key == "adaptive_shedding") adaptive_shedding_ = ParseBool(value);
+                else if (key == "queue_wait_target_ms") queue_wait_target_ms_ = std::stoi(value);
+                else if (key == "retry_after") retry_after_ = std::stoi(value);
+                else if (key == "header_timeout") header_timeout_ = std::stoi(value);
+                else if (key == "body_timeout") body_timeout_ = std::stoi(value);
+                else if (key == "write_timeout") write_timeout_ = std::stoi(value);
+                else if (key == "max_header_size") max_header_size_ = std::stoi(value);
+                else if (key == "max_body_size") max_body_size_ = std::stoi(value);
+                else if (key == "max_connections_per_ip") max_connections_per_ip_ = std::stoi(value);
+                else if (key == "slow_query_ms") slow_query_ms_ = std::stoi(value);
+                else if (key == "trace_buffer_size") trace_buffer_size_ = std::stoi(value);
+                else if (key == "slow_query_log") slow_query_log_ = value;
+                else if (key == "cache_control") cache_control_ = value;
+                else if (key == "generation_poll_interval") generation_poll_interval_ = std::stoi(value);
+                else if (key == "batch_max_queries") batch_max_queries_ = std::stoi(value);
+                else if (key == "batch_max_body_size") batch_max_body_size_ = std::stoi(value);
+                else if (key == "search_timeout_ms") search_timeout_ms_ = std::stoi(value);
             }
         }
     }
@@ -72,7 +129,7 @@ bool Config::Load(const std::string& filename) {
     file.close();
     std::cout << "Config loaded successfully from: " << filename << std::endl;
 
-    //     
+    // Вывод загруженных настроек для отладки
     std::cout << "Database: " << db_host_ << ":" << db_port_ << "/" << db_name_ << std::endl;
     std::cout << "Spider start URL: " << start_url_ << " (depth: " << max_depth_ << ")" << std::endl;
     std::cout << "Server port: " << server_port_ << std::endl;
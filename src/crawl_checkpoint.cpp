@@ -0,0 +1,272 @@
+#include "crawl_checkpoint.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char kMagic[4] = { 'S', 'P', 'C', 'K' };
+const char kTrailer[4] = { 'E', 'N', 'D', '1' };
+const uint64_t kVersion = 2;
+const uint64_t kFnvOffset = 14695981039346656037ULL;
+
+void HashBytes(uint64_t& hash, const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+}
+
+// Запись с подсчетом контрольной суммы
+class Writer {
+public:
+    explicit Writer(const std::string& path) : out_(path, std::ios::binary | std::ios::trunc) {}
+
+    bool IsOpen() const { return out_.is_open(); }
+
+    void Bytes(const char* data, size_t size) {
+        HashBytes(hash_, data, size);
+        out_.write(data, static_cast<std::streamsize>(size));
+    }
+
+    void U64(uint64_t value) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<char>(value >> (i * 8));
+        }
+        Bytes(bytes, sizeof(bytes));
+    }
+
+    void Varint(uint64_t value) {
+        char bytes[10];
+        size_t size = 0;
+        while (value >= 0x80) {
+            bytes[size++] = static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        bytes[size++] = static_cast<char>(value);
+        Bytes(bytes, size);
+    }
+
+    void String(const std::string& value) {
+        Varint(value.size());
+        Bytes(value.data(), value.size());
+    }
+
+    void Task(const UrlTask& task) {
+        Varint(static_cast<uint64_t>(task.depth) + 1);
+        String(task.url);
+        String(task.etag);
+        String(task.last_modified);
+    }
+
+    // Трейлер в сумму не входит
+    bool Finish() {
+        uint64_t hash = hash_;
+        out_.write(kTrailer, sizeof(kTrailer));
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<char>(hash >> (i * 8));
+        }
+        out_.write(bytes, sizeof(bytes));
+        out_.close();
+        return !out_.fail();
+    }
+
+private:
+    std::ofstream out_;
+    uint64_t hash_ = kFnvOffset;
+};
+
+class Reader {
+public:
+    explicit Reader(std::istream& in) : in_(in) {}
+
+    bool Bytes(char* data, size_t size) {
+        return static_cast<bool>(in_.read(data, static_cast<std::streamsize>(size)));
+    }
+
+    bool U64(uint64_t& value) {
+        unsigned char bytes[8];
+        if (!Bytes(reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+        }
+        return true;
+    }
+
+    bool Varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int byte = in_.get();
+            if (byte == EOF) {
+                return false;
+            }
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool String(std::string& value) {
+        uint64_t length = 0;
+        if (!Varint(length)) {
+            return false;
+        }
+        value.resize(length);
+        return length == 0 || Bytes(&value[0], length);
+    }
+
+private:
+    std::istream& in_;
+};
+
+} // namespace
+
+bool CrawlCheckpoint::Save(const std::string& path, const SeenSet& seen, Frontier& frontier,
+    const std::vector<UrlTask>& in_flight, Summary* summary) {
+    const std::string tmp_path = path + ".tmp";
+    Summary written;
+    {
+        Writer writer(tmp_path);
+        if (!writer.IsOpen()) {
+            std::cerr << "Cannot write checkpoint: " << tmp_path << std::endl;
+            return false;
+        }
+
+        writer.Bytes(kMagic, sizeof(kMagic));
+        writer.U64(kVersion);
+
+        seen.ForEach([&](uint64_t fingerprint) {
+            writer.U64(fingerprint);
+            ++written.seen;
+        });
+        writer.U64(0);
+
+        // Прерванные загрузки первыми: их URL уже отмечены посещенными
+        for (const auto& task : in_flight) {
+            writer.Task(task);
+            ++written.queued;
+        }
+        frontier.ForEach([&](const UrlTask& task) {
+            writer.Task(task);
+            ++written.queued;
+        });
+        writer.Varint(0);
+
+        if (!writer.Finish()) {
+            std::cerr << "Cannot write checkpoint: " << tmp_path << std::endl;
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Cannot rename checkpoint: " << tmp_path << std::endl;
+        return false;
+    }
+
+    if (summary) {
+        *summary = written;
+    }
+    return true;
+}
+
+// Сверяет контрольную сумму до того, как что-либо загружать
+bool CrawlCheckpoint::Verify(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        return false;
+    }
+    const std::streamoff size = in.tellg();
+    const std::streamoff trailer_size = sizeof(kTrailer) + 8;
+    if (size < static_cast<std::streamoff>(sizeof(kMagic)) + trailer_size) {
+        std::cerr << "Checkpoint is truncated: " << path << std::endl;
+        return false;
+    }
+
+    in.seekg(0);
+    uint64_t hash = kFnvOffset;
+    char buffer[65536];
+    for (std::streamoff left = size - trailer_size; left > 0;) {
+        std::streamsize chunk = static_cast<std::streamsize>(std::min<std::streamoff>(left, sizeof(buffer)));
+        if (!in.read(buffer, chunk)) {
+            return false;
+        }
+        HashBytes(hash, buffer, static_cast<size_t>(chunk));
+        left -= chunk;
+    }
+
+    char trailer[sizeof(kTrailer)];
+    uint64_t stored = 0;
+    Reader reader(in);
+    if (!reader.Bytes(trailer, sizeof(trailer)) || !reader.U64(stored)) {
+        return false;
+    }
+    if (!std::equal(trailer, trailer + sizeof(trailer), kTrailer) || stored != hash) {
+        std::cerr << "Checkpoint is damaged: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CrawlCheckpoint::LoadFile(const std::string& path, SeenSet& seen, Frontier& frontier, Summary* summary) {
+    std::ifstream in(path, std::ios::binary);
+    Reader reader(in);
+
+    char magic[sizeof(kMagic)];
+    uint64_t version = 0;
+    if (!reader.Bytes(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kMagic) ||
+        !reader.U64(version) || version != kVersion) {
+        std::cerr << "Unsupported checkpoint format: " << path << std::endl;
+        return false;
+    }
+
+    Summary loaded;
+    uint64_t fingerprint = 0;
+    while (reader.U64(fingerprint) && fingerprint != 0) {
+        seen.InsertFingerprint(fingerprint);
+        ++loaded.seen;
+    }
+
+    uint64_t depth = 0;
+    while (reader.Varint(depth) && depth != 0) {
+        UrlTask task;
+        task.depth = static_cast<int>(depth - 1);
+        if (!reader.String(task.url) || !reader.String(task.etag) || !reader.String(task.last_modified)) {
+            break;
+        }
+        frontier.Push(std::move(task));
+        ++loaded.queued;
+    }
+
+    if (summary) {
+        *summary = loaded;
+    }
+    return true;
+}
+
+bool CrawlCheckpoint::Load(const std::string& path, SeenSet& seen, Frontier& frontier, Summary* summary) {
+    for (const std::string& candidate : { path, path + ".tmp" }) {
+        if (!Verify(candidate)) {
+            continue;
+        }
+        if (LoadFile(candidate, seen, frontier, summary)) {
+            std::cout << "Loaded checkpoint " << candidate << std::endl;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CrawlCheckpoint::Remove(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + ".tmp").c_str());
+}
\ No newline at end of file
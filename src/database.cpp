@@ -1,10 +1,98 @@
 #include "database.h"
+#include "metrics.h"
+#include "trace.h"
 #include <iostream>
 #include <algorithm>
 #include <sstream>
 #include <regex>
 #include <map>
 #include <thread>
+#include <chrono>
+
+namespace {
+
+struct DatabaseMetrics {
+    Metrics::Id search_seconds;
+    Metrics::Id snippet_seconds;
+    Metrics::Id pool_wait_seconds;
+    Metrics::Id search_timeouts;
+};
+
+const DatabaseMetrics& GetDatabaseMetrics() {
+    static const DatabaseMetrics ids = [] {
+        auto& metrics = Metrics::Instance();
+        DatabaseMetrics result;
+        result.search_seconds = metrics.RegisterHistogram("db_search_seconds",
+            "Time spent in the SearchDocuments SQL query", Metrics::LatencyBuckets());
+        result.snippet_seconds = metrics.RegisterHistogram("db_snippet_seconds",
+            "Time spent building snippets for search results", Metrics::LatencyBuckets());
+        result.pool_wait_seconds = metrics.RegisterHistogram("db_pool_wait_seconds",
+            "Time a search waited for a database connection", Metrics::LatencyBuckets());
+        result.search_timeouts = metrics.RegisterCounter("db_search_timeouts_total",
+            "Searches that ran out of time budget and returned partial results");
+        return result;
+    }();
+    return ids;
+}
+
+// Любое изменение индекса увеличивает поколение; сервер строит по нему ETag ответов
+const char kBumpGenerationSql[] = "UPDATE index_state SET generation = generation + 1 WHERE id = 1";
+
+// Предел для упрощенного поиска после истечения бюджета основного запроса
+const int kFallbackTimeoutMs = 50;
+// Сколько документов самого редкого слова проверяет упрощенный поиск
+const int kFallbackCandidates = 1000;
+
+long long MillisecondsUntil(std::chrono::steady_clock::time_point deadline) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+}
+
+// Запрос документов, содержащих все слова. Если id слов уже известны,
+// таблица words в запросе не нужна.
+std::string BuildSearchQuery(pqxx::transaction_base& txn, const std::vector<std::string>& search_words,
+    const std::vector<int>* word_ids, int limit, int offset) {
+    std::string query =
+        "SELECT d.url, d.title, d.content, SUM(dw.frequency) as relevance "
+        "FROM documents d "
+        "JOIN document_words dw ON d.id = dw.document_id ";
+    size_t term_count = 0;
+
+    if (word_ids) {
+        query += "WHERE dw.word_id IN (";
+        for (size_t i = 0; i < word_ids->size(); ++i) {
+            if (i > 0) query += ", ";
+            query += std::to_string((*word_ids)[i]);
+        }
+        query += ") GROUP BY d.id, d.url, d.title, d.content HAVING COUNT(DISTINCT dw.word_id) = ";
+        term_count = word_ids->size();
+    }
+    else {
+        query += "JOIN words w ON dw.word_id = w.id WHERE w.word IN (";
+        for (size_t i = 0; i < search_words.size(); ++i) {
+            if (i > 0) query += ", ";
+            query += txn.quote(search_words[i]);
+        }
+        query += ") GROUP BY d.id, d.url, d.title, d.content HAVING COUNT(DISTINCT w.word) = ";
+        term_count = search_words.size();
+    }
+
+    query +=
+        std::to_string(term_count) + " "
+        "ORDER BY relevance DESC "
+        "LIMIT " + std::to_string(limit);
+
+    if (offset > 0) {
+        query += " OFFSET " + std::to_string(offset);
+    }
+
+    return query;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
 
 Database::Database() : connected_(false) {}
 
@@ -25,6 +113,7 @@ bool Database::Connect(const std::string& host, int port, const std::string& dbn
             "password=" + password;
 
         conn_ = std::make_unique<pqxx::connection>(connection_string);
+        connection_string_ = connection_string;
 
         if (conn_->is_open()) {
             connected_ = true;
@@ -42,7 +131,60 @@ bool Database::Connect(const std::string& host, int port, const std::string& dbn
     }
 }
 
+int Database::OpenReadPool(int size) {
+    std::lock_guard<std::mutex> pool_lock(read_pool_mutex_);
+    if (!connected_) return 0;
+
+    for (int i = 0; i < size; ++i) {
+        try {
+            auto connection = std::make_unique<pqxx::connection>(connection_string_);
+            idle_read_connections_.push_back(connection.get());
+            read_pool_.push_back(std::move(connection));
+        }
+        catch (const std::exception& e) {
+            // Работаем с тем, что удалось открыть: поиск все равно будет корректным
+            std::cerr << "Error opening read connection: " << e.what() << std::endl;
+            break;
+        }
+    }
+
+    std::cout << "Read connection pool: " << read_pool_.size() << " connections" << std::endl;
+    return static_cast<int>(read_pool_.size());
+}
+
+Database::ReadConnection::ReadConnection(Database& db) : db_(db) {
+    std::unique_lock<std::mutex> pool_lock(db_.read_pool_mutex_);
+    if (db_.read_pool_.empty()) {
+        pool_lock.unlock();
+        lock_ = std::unique_lock<std::mutex>(db_.db_mutex_);
+        conn_ = db_.conn_.get();
+        return;
+    }
+
+    db_.read_pool_cv_.wait(pool_lock, [this] { return !db_.idle_read_connections_.empty(); });
+    conn_ = db_.idle_read_connections_.back();
+    db_.idle_read_connections_.pop_back();
+}
+
+Database::ReadConnection::~ReadConnection() {
+    if (lock_.owns_lock()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> pool_lock(db_.read_pool_mutex_);
+        db_.idle_read_connections_.push_back(conn_);
+    }
+    db_.read_pool_cv_.notify_one();
+}
+
 void Database::Disconnect() {
+    {
+        std::lock_guard<std::mutex> pool_lock(read_pool_mutex_);
+        idle_read_connections_.clear();
+        read_pool_.clear();
+    }
+
     std::lock_guard<std::mutex> lock(db_mutex_);
     if (connected_ && conn_) {
         conn_->close();
@@ -58,7 +200,7 @@ bool Database::CreateTables() {
     try {
         pqxx::work txn(*conn_);
 
-        //  
+        // Таблица документов
         txn.exec(
             "CREATE TABLE IF NOT EXISTS documents ("
             "id SERIAL PRIMARY KEY,"
@@ -69,7 +211,13 @@ bool Database::CreateTables() {
             ")"
         );
 
-        //  
+        // Валидаторы HTTP и ссылки страницы для условного повторного обхода;
+        // ALTER - для баз, созданных до появления этих столбцов
+        txn.exec("ALTER TABLE documents ADD COLUMN IF NOT EXISTS etag TEXT");
+        txn.exec("ALTER TABLE documents ADD COLUMN IF NOT EXISTS last_modified TEXT");
+        txn.exec("ALTER TABLE documents ADD COLUMN IF NOT EXISTS links TEXT");
+
+        // Таблица слов
         txn.exec(
             "CREATE TABLE IF NOT EXISTS words ("
             "id SERIAL PRIMARY KEY,"
@@ -77,7 +225,7 @@ bool Database::CreateTables() {
             ")"
         );
 
-        //  
+        // Таблица связей
         txn.exec(
             "CREATE TABLE IF NOT EXISTS document_words ("
             "document_id INTEGER REFERENCES documents(id) ON DELETE CASCADE,"
@@ -87,12 +235,21 @@ bool Database::CreateTables() {
             ")"
         );
 
-        //    
+        // Индексы для улучшения производительности
         txn.exec("CREATE INDEX IF NOT EXISTS idx_words_word ON words(word)");
         txn.exec("CREATE INDEX IF NOT EXISTS idx_document_words_word_id ON document_words(word_id)");
         txn.exec("CREATE INDEX IF NOT EXISTS idx_documents_url ON documents(url)");
         txn.exec("CREATE INDEX IF NOT EXISTS idx_document_words_document_id ON document_words(document_id)");
 
+        // Поколение индекса (всегда одна строка)
+        txn.exec(
+            "CREATE TABLE IF NOT EXISTS index_state ("
+            "id INTEGER PRIMARY KEY CHECK (id = 1),"
+            "generation BIGINT NOT NULL"
+            ")"
+        );
+        txn.exec("INSERT INTO index_state (id, generation) VALUES (1, 0) ON CONFLICT (id) DO NOTHING");
+
         txn.commit();
         std::cout << "Database tables created successfully" << std::endl;
         return true;
@@ -110,7 +267,7 @@ int Database::AddDocument(const std::string& url, const std::string& title, cons
     try {
         pqxx::work txn(*conn_);
 
-        //   
+        // Проверяем существование документа
         pqxx::result result = txn.exec(
             "SELECT id FROM documents WHERE url = " + txn.quote(url)
         );
@@ -119,7 +276,7 @@ int Database::AddDocument(const std::string& url, const std::string& title, cons
             return result[0][0].as<int>();
         }
 
-        //   
+        // Добавляем новый документ
         result = txn.exec(
             "INSERT INTO documents (url, title, content) VALUES (" +
             txn.quote(url) + ", " + txn.quote(title) + ", " + txn.quote(content) +
@@ -176,6 +333,97 @@ bool Database::UpdateDocument(const std::string& url, const std::string& title,
     }
 }
 
+std::unordered_map<std::string, DocumentValidators> Database::GetDocumentValidators(
+    const std::vector<std::string>& urls) {
+    std::unordered_map<std::string, DocumentValidators> validators;
+    if (!connected_ || urls.empty()) return validators;
+
+    ReadConnection connection(*this);
+    try {
+        pqxx::work txn(connection.Get());
+
+        std::string query =
+            "SELECT url, etag, last_modified FROM documents "
+            "WHERE (etag IS NOT NULL OR last_modified IS NOT NULL) AND url IN (";
+        for (size_t i = 0; i < urls.size(); ++i) {
+            if (i > 0) query += ", ";
+            query += txn.quote(urls[i]);
+        }
+        query += ")";
+
+        for (const auto& row : txn.exec(query)) {
+            DocumentValidators& stored = validators[row["url"].as<std::string>()];
+            stored.etag = row["etag"].is_null() ? "" : row["etag"].as<std::string>();
+            stored.last_modified = row["last_modified"].is_null() ? "" : row["last_modified"].as<std::string>();
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error getting document validators: " << e.what() << std::endl;
+    }
+    return validators;
+}
+
+bool Database::SetDocumentValidators(int document_id, const std::string& etag, const std::string& last_modified,
+    const std::vector<std::string>& links) {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!connected_) return false;
+
+    try {
+        pqxx::work txn(*conn_);
+
+        // Ссылки хранятся по одной на строку: в URL перевода строки не бывает
+        std::string joined;
+        for (const auto& link : links) {
+            joined += link;
+            joined += '\n';
+        }
+
+        txn.exec(
+            "UPDATE documents SET etag = " + txn.quote(etag) +
+            ", last_modified = " + txn.quote(last_modified) +
+            ", links = " + txn.quote(joined) +
+            " WHERE id = " + txn.quote(document_id)
+        );
+
+        txn.commit();
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error setting document validators: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::vector<std::string> Database::GetDocumentLinks(const std::string& url) {
+    std::vector<std::string> links;
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!connected_) return links;
+
+    try {
+        pqxx::work txn(*conn_);
+        pqxx::result result = txn.exec(
+            "SELECT links FROM documents WHERE url = " + txn.quote(url)
+        );
+
+        if (result.empty() || result[0][0].is_null()) {
+            return links;
+        }
+
+        std::istringstream stream(result[0][0].as<std::string>());
+        std::string link;
+        while (std::getline(stream, link)) {
+            if (!link.empty()) {
+                links.push_back(link);
+            }
+        }
+        return links;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error getting document links: " << e.what() << std::endl;
+        return links;
+    }
+}
+
 std::vector<Document> Database::GetAllDocuments() {
     std::vector<Document> documents;
     std::lock_guard<std::mutex> lock(db_mutex_);
@@ -209,7 +457,7 @@ int Database::AddWord(const std::string& word) {
     try {
         pqxx::work txn(*conn_);
 
-        //   ,   -  ID
+        // Пытаемся вставить слово, если существует - возвращаем ID
         pqxx::result result = txn.exec(
             "INSERT INTO words (word) VALUES (" + txn.quote(word) +
             ") ON CONFLICT (word) DO UPDATE SET word = EXCLUDED.word RETURNING id"
@@ -293,15 +541,15 @@ void Database::UpdateDocumentWords(int document_id, const std::map<std::string,
     if (!connected_) return;
 
     try {
-        //      
+        // Создаем одну транзакцию для всех операций
         pqxx::work txn(*conn_);
 
-        //   
+        // Очищаем старые связи
         txn.exec("DELETE FROM document_words WHERE document_id = " + txn.quote(document_id));
 
-        //     
+        // Добавляем новые слова и связи
         for (const auto& [word, freq] : word_frequencies) {
-            //      ID    
+            // Вставляем слово и получаем его ID в рамках одной транзакции
             pqxx::result word_result = txn.exec(
                 "INSERT INTO words (word) VALUES (" + txn.quote(word) +
                 ") ON CONFLICT (word) DO UPDATE SET word = EXCLUDED.word RETURNING id"
@@ -310,7 +558,7 @@ void Database::UpdateDocumentWords(int document_id, const std::map<std::string,
             if (!word_result.empty()) {
                 int word_id = word_result[0][0].as<int>();
 
-                //     
+                // Вставляем связь документа и слова
                 txn.exec(
                     "INSERT INTO document_words (document_id, word_id, frequency) VALUES (" +
                     txn.quote(document_id) + ", " + txn.quote(word_id) + ", " + txn.quote(freq) +
@@ -319,6 +567,7 @@ void Database::UpdateDocumentWords(int document_id, const std::map<std::string,
             }
         }
 
+        txn.exec(kBumpGenerationSql);
         txn.commit();
     }
     catch (const std::exception& e) {
@@ -333,6 +582,7 @@ void Database::ClearDocumentWords(int document_id) {
     try {
         pqxx::work txn(*conn_);
         txn.exec("DELETE FROM document_words WHERE document_id = " + txn.quote(document_id));
+        txn.exec(kBumpGenerationSql);
         txn.commit();
     }
     catch (const std::exception& e) {
@@ -340,47 +590,192 @@ void Database::ClearDocumentWords(int document_id) {
     }
 }
 
-std::vector<SearchResult> Database::SearchDocuments(const std::vector<std::string>& search_words, int limit) {
-    std::vector<SearchResult> results;
+void Database::BumpIndexGeneration() {
     std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!connected_) return;
 
-    if (!connected_ || search_words.empty()) return results;
+    try {
+        pqxx::work txn(*conn_);
+        txn.exec(kBumpGenerationSql);
+        txn.commit();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error bumping index generation: " << e.what() << std::endl;
+    }
+}
+
+long long Database::GetIndexGeneration() {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!connected_) return -1;
 
     try {
         pqxx::work txn(*conn_);
+        auto result = txn.exec("SELECT generation FROM index_state WHERE id = 1");
+        if (result.empty()) {
+            return -1;
+        }
+        return result[0][0].as<long long>();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error getting index generation: " << e.what() << std::endl;
+        return -1;
+    }
+}
 
-        //     ,   
-        std::string query =
-            "SELECT d.url, d.title, d.content, SUM(dw.frequency) as relevance "
-            "FROM documents d "
-            "JOIN document_words dw ON d.id = dw.document_id "
-            "JOIN words w ON dw.word_id = w.id "
-            "WHERE w.word IN (";
+IndexStats Database::GetIndexStats() {
+    IndexStats stats;
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!connected_) return stats;
 
-        for (size_t i = 0; i < search_words.size(); ++i) {
+    try {
+        pqxx::work txn(*conn_);
+        auto result = txn.exec(
+            "SELECT "
+            "(SELECT reltuples::bigint FROM pg_class WHERE relname = 'documents'), "
+            "(SELECT reltuples::bigint FROM pg_class WHERE relname = 'words')"
+        );
+        if (!result.empty()) {
+            stats.documents = result[0][0].is_null() ? 0 : std::max(result[0][0].as<long long>(), 0LL);
+            stats.words = result[0][1].is_null() ? 0 : std::max(result[0][1].as<long long>(), 0LL);
+        }
+
+        result = txn.exec("SELECT generation FROM index_state WHERE id = 1");
+        if (!result.empty()) {
+            stats.generation = result[0][0].as<long long>();
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error getting index stats: " << e.what() << std::endl;
+    }
+    return stats;
+}
+
+std::vector<SearchResult> Database::SearchDocuments(const std::vector<std::string>& search_words, int limit,
+    int offset, SearchTimings* timings, SearchBudget* budget) {
+    return RunSearch(search_words, nullptr, limit, offset, timings, budget);
+}
+
+std::vector<SearchResult> Database::SearchDocumentsByIds(const std::vector<int>& word_ids,
+    const std::vector<std::string>& search_words, int limit, int offset, SearchTimings* timings,
+    SearchBudget* budget) {
+    return RunSearch(search_words, &word_ids, limit, offset, timings, budget);
+}
+
+std::unordered_map<std::string, int> Database::ResolveWordIds(const std::vector<std::string>& words) {
+    std::unordered_map<std::string, int> word_ids;
+    if (!connected_ || words.empty()) return word_ids;
+
+    ReadConnection connection(*this);
+    try {
+        pqxx::work txn(connection.Get());
+
+        std::string query = "SELECT word, id FROM words WHERE word IN (";
+        for (size_t i = 0; i < words.size(); ++i) {
             if (i > 0) query += ", ";
-            query += txn.quote(search_words[i]);
+            query += txn.quote(words[i]);
         }
+        query += ")";
 
-        query +=
-            ") "
-            "GROUP BY d.id, d.url, d.title, d.content "
-            "HAVING COUNT(DISTINCT w.word) = " + std::to_string(search_words.size()) + " "
-            "ORDER BY relevance DESC "
-            "LIMIT " + std::to_string(limit);
+        for (const auto& row : txn.exec(query)) {
+            word_ids.emplace(row["word"].as<std::string>(), row["id"].as<int>());
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error resolving word IDs: " << e.what() << std::endl;
+    }
+    return word_ids;
+}
+
+std::vector<SearchResult> Database::RunSearch(const std::vector<std::string>& search_words,
+    const std::vector<int>* word_ids, int limit, int offset, SearchTimings* timings, SearchBudget* budget) {
+    std::vector<SearchResult> results;
+    auto& metrics = Metrics::Instance();
+    const auto& ids = GetDatabaseMetrics();
+
+    if (!connected_ || search_words.empty() || (word_ids && word_ids->empty())) return results;
+
+    // Ожидание свободного соединения - узкое место при параллельных запросах
+    auto wait_start = std::chrono::steady_clock::now();
+    ReadConnection connection(*this);
+    metrics.Observe(ids.pool_wait_seconds, SecondsSince(wait_start));
+
+    RequestTrace* trace = RequestTrace::Current();
+    if (trace) {
+        trace->AddSpan("db.wait", wait_start, std::chrono::steady_clock::now());
+    }
+
+    bool limited = budget && budget->Limited();
+
+    try {
+        auto retrieve_start = std::chrono::steady_clock::now();
+        pqxx::result result;
+
+        if (limited && MillisecondsUntil(budget->deadline) <= 0) {
+            // Бюджет истратили в ожидании соединения: только упрощенный поиск
+            budget->partial = true;
+        }
+        else {
+            try {
+                pqxx::work txn(connection.Get());
+
+                // Остаток бюджета ограничивает сам запрос на стороне PostgreSQL (0 отключил бы предел)
+                if (limited) {
+                    txn.exec("SET LOCAL statement_timeout = " +
+                        std::to_string(std::max(MillisecondsUntil(budget->deadline), 1LL)));
+                }
+
+                result = txn.exec(BuildSearchQuery(txn, search_words, word_ids, limit, offset));
+            }
+            catch (const pqxx::query_canceled&) {
+                if (!limited) throw;
+                // Сработал statement_timeout
+                budget->partial = true;
+            }
+        }
 
-        pqxx::result result = txn.exec(query);
+        if (limited && budget->partial) {
+            metrics.Increment(ids.search_timeouts);
+            auto fallback_start = std::chrono::steady_clock::now();
+            result = RunFallbackSearch(connection.Get(), search_words, word_ids, limit, offset);
+            if (trace) {
+                trace->AddSpan("db.fallback", fallback_start, std::chrono::steady_clock::now());
+            }
+        }
+        auto snippet_start = std::chrono::steady_clock::now();
 
+        results.reserve(result.size());
         for (const auto& row : result) {
             std::string url = row["url"].as<std::string>();
             std::string title = row["title"].as<std::string>();
             std::string content = row["content"].as<std::string>();
             int relevance = row["relevance"].as<int>();
 
-            std::string snippet = GenerateSnippet(content, search_words);
+            // Кооперативная проверка срока: после него сниппеты берутся из начала текста
+            std::string snippet;
+            if (limited && (budget->partial || std::chrono::steady_clock::now() >= budget->deadline)) {
+                budget->partial = true;
+                snippet = content.length() <= 200 ? content : content.substr(0, 200) + "...";
+            }
+            else {
+                snippet = GenerateSnippet(content, search_words);
+            }
             results.emplace_back(url, title, snippet, relevance);
         }
 
+        auto snippet_end = std::chrono::steady_clock::now();
+        metrics.Observe(ids.search_seconds, std::chrono::duration<double>(snippet_start - retrieve_start).count());
+        metrics.Observe(ids.snippet_seconds, std::chrono::duration<double>(snippet_end - snippet_start).count());
+
+        if (trace) {
+            trace->AddSpan("db.query", retrieve_start, snippet_start);
+            trace->AddSpan("db.snippets", snippet_start, snippet_end);
+        }
+
+        if (timings) {
+            timings->retrieve_ms = std::chrono::duration<double, std::milli>(snippet_start - retrieve_start).count();
+            timings->snippet_ms = std::chrono::duration<double, std::milli>(snippet_end - snippet_start).count();
+        }
+
         return results;
     }
     catch (const std::exception& e) {
@@ -389,22 +784,88 @@ std::vector<SearchResult> Database::SearchDocuments(const std::vector<std::strin
     }
 }
 
+pqxx::result Database::RunFallbackSearch(pqxx::connection& connection,
+    const std::vector<std::string>& search_words, const std::vector<int>* word_ids, int limit, int offset) {
+    // Те же условия, что и в основном запросе (документ содержит все слова), но
+    // проверяются только первые kFallbackCandidates документов самого редкого слова.
+    // Редкость оценивается счетом, ограниченным тем же числом, поэтому запрос читает
+    // по индексу не больше (слов + 1) * kFallbackCandidates строк document_words.
+    // Результат - подмножество полного ответа, а не документы по одному из слов.
+    const std::string cap = std::to_string(kFallbackCandidates);
+
+    try {
+        pqxx::work txn(connection);
+        txn.exec("SET LOCAL statement_timeout = " + std::to_string(kFallbackTimeoutMs));
+
+        std::string terms;
+        size_t term_count = 0;
+        if (word_ids) {
+            terms = "SELECT unnest(ARRAY[";
+            for (size_t i = 0; i < word_ids->size(); ++i) {
+                if (i > 0) terms += ", ";
+                terms += std::to_string((*word_ids)[i]);
+            }
+            terms += "]::integer[]) AS id";
+            term_count = word_ids->size();
+        }
+        else {
+            terms = "SELECT id FROM words WHERE word IN (";
+            for (size_t i = 0; i < search_words.size(); ++i) {
+                if (i > 0) terms += ", ";
+                terms += txn.quote(search_words[i]);
+            }
+            terms += ")";
+            term_count = search_words.size();
+        }
+
+        // Слова, которых нет в словаре, не попадут в terms, и HAVING отсеет все документы
+        std::string query =
+            "WITH terms AS (" + terms + "), "
+            "rarest AS ("
+            "SELECT t.id FROM terms t ORDER BY ("
+            "SELECT COUNT(*) FROM (SELECT 1 FROM document_words x WHERE x.word_id = t.id LIMIT " + cap + ") s"
+            ") LIMIT 1), "
+            "candidates AS ("
+            "SELECT dw.document_id FROM document_words dw "
+            "WHERE dw.word_id = (SELECT id FROM rarest) LIMIT " + cap + ") "
+            "SELECT d.url, d.title, d.content, SUM(dw.frequency) as relevance "
+            "FROM candidates c "
+            "JOIN document_words dw ON dw.document_id = c.document_id "
+            "AND dw.word_id = ANY(ARRAY(SELECT id FROM terms)) "
+            "JOIN documents d ON d.id = c.document_id "
+            "GROUP BY d.id, d.url, d.title, d.content "
+            "HAVING COUNT(DISTINCT dw.word_id) = " + std::to_string(term_count) + " "
+            "ORDER BY relevance DESC "
+            "LIMIT " + std::to_string(limit);
+        if (offset > 0) {
+            query += " OFFSET " + std::to_string(offset);
+        }
+
+        return txn.exec(query);
+    }
+    catch (const std::exception& e) {
+        // partial уже выставлен: пустой ответ честнее документов, не содержащих всех слов
+        std::cerr << "Fallback search failed: " << e.what() << std::endl;
+        return pqxx::result();
+    }
+}
+
 std::string Database::GenerateSnippet(const std::string& content, const std::vector<std::string>& search_words) {
     if (content.length() <= 200) {
         return content;
     }
 
-    //    ,     
+    // Если есть поисковые слова, попробуем найти контекст вокруг них
     if (!search_words.empty()) {
         std::string content_lower = content;
         std::transform(content_lower.begin(), content_lower.end(), content_lower.begin(),
             [](unsigned char c) { return std::tolower(c); });
 
-        //       
+        // Ищем первое вхождение любого из поисковых слов
         for (const auto& word : search_words) {
             size_t pos = content_lower.find(word);
             if (pos != std::string::npos) {
-                //  ,    
+                // Нашли слово, берем контекст вокруг него
                 size_t start = (pos > 100) ? pos - 100 : 0;
                 size_t end = std::min(content.length(), start + 200);
                 std::string snippet = content.substr(start, end - start);
@@ -417,7 +878,7 @@ std::string Database::GenerateSnippet(const std::string& content, const std::vec
         }
     }
 
-    //           ,  
+    // Если не нашли поисковых слов или они не найдены в тексте, возвращаем начало
     return content.substr(0, 200) + "...";
 }
 
@@ -0,0 +1,111 @@
+#include "dns_cache.h"
+#include <memory>
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+DnsCache::DnsCache() = default;
+
+DnsCache::~DnsCache() {
+    // Незавершенные resolve отбрасываются: кэш живет в HttpClientContext,
+    // и клиентов, ждущих ответа, к этому моменту уже нет
+    resolve_pool_.stop();
+    resolve_pool_.join();
+}
+
+void DnsCache::SetTtl(std::chrono::seconds ttl, std::chrono::seconds negative_ttl) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = ttl;
+    negative_ttl_ = negative_ttl;
+}
+
+void DnsCache::AsyncResolve(const std::string& host, const std::string& port,
+    net::any_io_executor executor, Handler handler) {
+    const std::string key = host + ":" + port;
+    const auto now = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = entries_[key];
+
+        // Ожидающий держит работу своего executor, иначе его io_context мог бы
+        // завершить run(), не дождавшись ответа от чужого resolve
+        auto tracked = net::prefer(executor, net::execution::outstanding_work.tracked);
+
+        if (entry.pending) {
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+            entry.waiters.push_back({ std::move(tracked), std::move(handler) });
+            return;
+        }
+
+        if (now < entry.expires) {
+            (entry.error ? negative_hits_ : hits_).fetch_add(1, std::memory_order_relaxed);
+            net::post(executor, [handler = std::move(handler), error = entry.error, results = entry.results]() {
+                handler(error, results);
+            });
+            return;
+        }
+
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        entry.pending = true;
+        entry.waiters.push_back({ std::move(tracked), std::move(handler) });
+
+        if (entries_.size() > kMaxEntries) {
+            EvictExpired(now);
+        }
+    }
+
+    // Resolve выполняется на потоке кэша, а не на executor первого запросившего:
+    // его io_context может остановиться раньше ответа, и тогда запись навсегда
+    // осталась бы pending. Ответ раздается всем ожидающим через их executor
+    auto resolver = std::make_shared<tcp::resolver>(resolve_pool_.get_executor());
+    resolver->async_resolve(host, port,
+        [this, key, resolver](boost::beast::error_code ec, Results results) {
+            OnResolved(key, ec, std::move(results));
+        });
+}
+
+void DnsCache::OnResolved(const std::string& key, boost::beast::error_code ec, Results results) {
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = entries_[key];
+        entry.pending = false;
+        entry.results = results;
+        entry.error = ec;
+        // Отмененный resolve не говорит ничего о самом имени, его не кэшируем
+        if (ec == net::error::operation_aborted) {
+            entry.expires = {};
+        }
+        else {
+            entry.expires = Clock::now() + (ec ? negative_ttl_ : ttl_);
+        }
+        waiters.swap(entry.waiters);
+    }
+
+    for (auto& waiter : waiters) {
+        net::post(waiter.executor, [handler = std::move(waiter.handler), ec, results]() {
+            handler(ec, results);
+        });
+    }
+}
+
+void DnsCache::EvictExpired(Clock::time_point now) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (!it->second.pending && it->second.expires <= now) {
+            it = entries_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+DnsCache::Stats DnsCache::GetStats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.negative_hits = negative_hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,516 @@
+#include "frontier.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void WriteVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void WriteString(std::string& out, const std::string& value) {
+    WriteVarint(out, value.size());
+    out.append(value);
+}
+
+bool ReadVarint(std::istream& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = in.get();
+        if (byte == EOF) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ReadString(std::istream& in, std::string& value) {
+    uint64_t length = 0;
+    if (!ReadVarint(in, length)) {
+        return false;
+    }
+    value.resize(length);
+    return length == 0 || static_cast<bool>(in.read(&value[0], static_cast<std::streamsize>(length)));
+}
+
+bool EndsWith(const std::string& s, const char* suffix) {
+    size_t n = std::char_traits<char>::length(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+uint64_t HostKey(const std::string& host) {
+    return std::hash<std::string>()(host);
+}
+
+} // namespace
+
+int DefaultFrontierPriority::UrlPriority(const UrlTask& task) const {
+    const std::string& url = task.url;
+    size_t scheme_end = url.find("://");
+    size_t path_start = url.find('/', scheme_end == std::string::npos ? 0 : scheme_end + 3);
+    std::string path = path_start == std::string::npos ? "/" : url.substr(path_start);
+
+    // Оценка ценности страницы по виду URL: 0 - лучше всего, 3 - хуже всего
+    int penalty = 0;
+    size_t query = path.find_first_of("?#");
+    if (query != std::string::npos) {
+        ++penalty;
+        path.resize(query);
+    }
+    if (std::count(path.begin(), path.end(), '/') > 3) {
+        ++penalty;
+    }
+    std::transform(path.begin(), path.end(), path.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (const char* ext : { ".pdf", ".jpg", ".jpeg", ".png", ".gif", ".zip", ".gz", ".mp3", ".mp4", ".exe", ".css", ".js" }) {
+        if (EndsWith(path, ext)) {
+            ++penalty;
+            break;
+        }
+    }
+
+    return std::clamp(std::max(task.depth, 0) * 4 + penalty, 0, kMaxPriority);
+}
+
+int DefaultFrontierPriority::HostPenalty(uint32_t fetched) const {
+    // Число двоичных разрядов: 1 загрузка - +1, 1000 загрузок - +10
+    int bits = 0;
+    while (fetched > 0) {
+        ++bits;
+        fetched >>= 1;
+    }
+    return bits;
+}
+
+Frontier::Frontier(Options options, std::unique_ptr<FrontierPriority> priority)
+    : options_(std::move(options)), priority_(std::move(priority)) {
+    if (!priority_) {
+        priority_ = std::make_unique<DefaultFrontierPriority>();
+    }
+    options_.memory_urls = std::max<size_t>(options_.memory_urls, 2);
+    options_.segment_urls = std::max<size_t>(options_.segment_urls, 1);
+
+    // Сегменты прошлого запуска ничего не значат без его состояния
+    std::error_code ec;
+    fs::create_directories(options_.spill_dir, ec);
+    for (const auto& entry : fs::directory_iterator(options_.spill_dir, ec)) {
+        if (entry.path().extension() == ".seg") {
+            fs::remove(entry.path(), ec);
+        }
+    }
+}
+
+Frontier::~Frontier() {
+    for (auto& segment : segments_) {
+        segment->file.close();
+        std::remove(segment->path.c_str());
+    }
+}
+
+std::string Frontier::HostOf(const std::string& url) {
+    size_t start = url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+    size_t end = url.find_first_of("/?#", start);
+    std::string host = url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    std::transform(host.begin(), host.end(), host.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return host;
+}
+
+Frontier::HostState& Frontier::GetHost(const std::string& host, const std::string& url) {
+    auto [it, inserted] = hosts_.try_emplace(host);
+    HostState& state = it->second;
+    if (!inserted) {
+        return state;
+    }
+
+    auto known = known_hosts_.find(HostKey(host));
+    if (known != known_hosts_.end()) {
+        state.delay = std::chrono::milliseconds(known->second.delay_ms);
+        state.fetched = known->second.fetched;
+        return state;
+    }
+
+    state.delay = options_.default_delay;
+    known_hosts_[HostKey(host)] = { static_cast<uint32_t>(state.delay.count()), 0 };
+
+    // Первым к новому хосту идет robots.txt: из него берется Crawl-delay
+    if (options_.fetch_robots) {
+        size_t scheme_end = url.find("://");
+        std::string scheme = scheme_end == std::string::npos ? "http" : url.substr(0, scheme_end);
+        AddToMemory(state, { scheme + "://" + host + "/robots.txt", 0, true }, -1);
+    }
+    return state;
+}
+
+void Frontier::AddToMemory(HostState& state, UrlTask task, int priority) {
+    state.urls.push({ std::move(task), priority, next_seq_++ });
+    ++memory_size_;
+}
+
+void Frontier::Push(UrlTask task) {
+    const std::string host = HostOf(task.url);
+    const int priority = priority_->UrlPriority(task);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (memory_size_ < options_.memory_urls) {
+        HostState& state = GetHost(host, task.url);
+        AddToMemory(state, std::move(task), priority);
+        Schedule(host, state);
+        return;
+    }
+
+    spill_.push_back({ std::move(task), priority });
+    if (spill_.size() >= options_.segment_urls) {
+        SpillBuffer();
+    }
+}
+
+void Frontier::Schedule(const std::string& host, HostState& state) {
+    if (state.status == HostStatus::Idle && !state.urls.empty()) {
+        state.status = HostStatus::Waiting;
+        waiting_.emplace(state.next_allowed, host);
+    }
+}
+
+void Frontier::PromoteReady(Clock::time_point now) {
+    while (!waiting_.empty() && waiting_.top().first <= now) {
+        auto [time, host] = waiting_.top();
+        waiting_.pop();
+
+        auto it = hosts_.find(host);
+        if (it == hosts_.end() || it->second.status != HostStatus::Waiting) {
+            continue;
+        }
+        HostState& state = it->second;
+        state.status = HostStatus::Runnable;
+        runnable_.emplace(state.urls.top().priority + priority_->HostPenalty(state.fetched), time, host);
+    }
+}
+
+// Хосты без URL в памяти и без загрузки в работе забываются не раньше, чем
+// истечет их задержка; остается только запись в known_hosts_
+void Frontier::SweepIdleHosts(Clock::time_point now) {
+    if (now < next_sweep_) {
+        return;
+    }
+    next_sweep_ = now + std::chrono::seconds(1);
+
+    for (auto it = hosts_.begin(); it != hosts_.end();) {
+        const HostState& state = it->second;
+        if (state.status == HostStatus::Idle && state.urls.empty() && state.next_allowed <= now) {
+            known_hosts_[HostKey(it->first)] = { static_cast<uint32_t>(state.delay.count()), state.fetched };
+            it = hosts_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+bool Frontier::TryPop(UrlTask& task, Clock::time_point& next_ready) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = Clock::now();
+
+    if (memory_size_ < options_.memory_urls / 2 && (!spill_.empty() || segment_size_ > 0)) {
+        Refill();
+    }
+    PromoteReady(now);
+    SweepIdleHosts(now);
+
+    while (!runnable_.empty()) {
+        const std::string host = std::get<2>(runnable_.top());
+        runnable_.pop();
+
+        auto it = hosts_.find(host);
+        if (it == hosts_.end() || it->second.status != HostStatus::Runnable) {
+            continue;
+        }
+
+        HostState& state = it->second;
+        task = state.urls.top().task;
+        state.urls.pop();
+        --memory_size_;
+        state.status = HostStatus::Busy;
+        ++state.fetched;
+        return true;
+    }
+
+    next_ready = waiting_.empty() ? Clock::time_point::max() : waiting_.top().first;
+    return false;
+}
+
+void Frontier::Complete(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(host);
+    if (it == hosts_.end()) {
+        return;
+    }
+
+    HostState& state = it->second;
+    state.status = HostStatus::Idle;
+    state.next_allowed = Clock::now() + state.delay;
+    Schedule(host, state);
+}
+
+void Frontier::SetHostDelay(const std::string& host, std::chrono::milliseconds delay) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(host);
+    if (it != hosts_.end()) {
+        it->second.delay = delay;
+    }
+    known_hosts_[HostKey(host)].delay_ms = static_cast<uint32_t>(delay.count());
+}
+
+// Буфер сортируется по (приоритет, URL) и пишется одним сегментом. Запись:
+// приоритет (байт), глубина, длина общего с предыдущим URL префикса,
+// длина остатка (varint) и сам остаток, затем ETag и Last-Modified
+// (varint длина и строка, обычно пустые).
+void Frontier::SpillBuffer() {
+    std::sort(spill_.begin(), spill_.end(), [](const SpilledUrl& a, const SpilledUrl& b) {
+        return std::tie(a.priority, a.task.url) < std::tie(b.priority, b.task.url);
+    });
+
+    std::string data;
+    const std::string* prev = nullptr;
+    for (const auto& entry : spill_) {
+        const std::string& url = entry.task.url;
+        size_t shared = 0;
+        if (prev) {
+            size_t limit = std::min(prev->size(), url.size());
+            while (shared < limit && (*prev)[shared] == url[shared]) {
+                ++shared;
+            }
+        }
+        data.push_back(static_cast<char>(entry.priority));
+        WriteVarint(data, static_cast<uint64_t>(entry.task.depth));
+        WriteVarint(data, shared);
+        WriteVarint(data, url.size() - shared);
+        data.append(url, shared, std::string::npos);
+        WriteString(data, entry.task.etag);
+        WriteString(data, entry.task.last_modified);
+        prev = &url;
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%06llu.seg", static_cast<unsigned long long>(next_segment_++));
+    auto segment = std::make_unique<Segment>();
+    segment->path = (fs::path(options_.spill_dir) / name).string();
+    {
+        std::ofstream file(segment->path, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (file) {
+            file.close();
+            segment->file.open(segment->path, std::ios::binary);
+        }
+    }
+
+    segment->remaining = spill_.size();
+    segment->bytes = data.size();
+    if (!ReadNext(*segment)) {
+        // URL остаются в буфере; следующая попытка, когда он вырастет еще на сегмент
+        std::cerr << "Cannot write frontier segment: " << segment->path << std::endl;
+        segment->file.close();
+        std::remove(segment->path.c_str());
+        options_.segment_urls += spill_.size();
+        return;
+    }
+    segment_size_ += spill_.size();
+    segments_.push_back(std::move(segment));
+    spill_.clear();
+}
+
+bool Frontier::ReadNext(Segment& segment) {
+    uint64_t depth = 0, shared = 0, length = 0;
+    int priority = segment.file.get();
+    if (priority == EOF || !ReadVarint(segment.file, depth) || !ReadVarint(segment.file, shared) ||
+        !ReadVarint(segment.file, length) || shared > segment.prev_url.size()) {
+        return false;
+    }
+
+    std::string url = segment.prev_url.substr(0, shared);
+    url.resize(shared + length);
+    segment.file.read(&url[shared], static_cast<std::streamsize>(length));
+    UrlTask task{ url, static_cast<int>(depth) };
+    if (!segment.file || !ReadString(segment.file, task.etag) || !ReadString(segment.file, task.last_modified)) {
+        return false;
+    }
+
+    segment.prev_url = std::move(url);
+    segment.next = { std::move(task), priority };
+    return true;
+}
+
+// Подчитывает лучшие вытесненные URL, пока память не заполнится на три четверти:
+// слияние по приоритету голов сегментов и отсортированного буфера
+void Frontier::Refill() {
+    std::sort(spill_.begin(), spill_.end(), [](const SpilledUrl& a, const SpilledUrl& b) {
+        return std::tie(a.priority, a.task.url) > std::tie(b.priority, b.task.url);
+    });
+
+    const size_t target = options_.memory_urls - options_.memory_urls / 4;
+    while (memory_size_ < target) {
+        Segment* best = nullptr;
+        for (auto& segment : segments_) {
+            if (!best || segment->next.priority < best->next.priority) {
+                best = segment.get();
+            }
+        }
+
+        SpilledUrl entry;
+        if (best && (spill_.empty() || best->next.priority <= spill_.back().priority)) {
+            entry = std::move(best->next);
+            --best->remaining;
+            --segment_size_;
+            if (best->remaining == 0 || !ReadNext(*best)) {
+                if (best->remaining > 0) {
+                    std::cerr << "Frontier segment is damaged, " << best->remaining
+                        << " URLs lost: " << best->path << std::endl;
+                    segment_size_ -= best->remaining;
+                }
+                best->file.close();
+                std::remove(best->path.c_str());
+                segments_.erase(std::find_if(segments_.begin(), segments_.end(),
+                    [best](const std::unique_ptr<Segment>& s) { return s.get() == best; }));
+            }
+        }
+        else if (!spill_.empty()) {
+            entry = std::move(spill_.back());
+            spill_.pop_back();
+        }
+        else {
+            break;
+        }
+
+        const std::string host = HostOf(entry.task.url);
+        HostState& state = GetHost(host, entry.task.url);
+        AddToMemory(state, std::move(entry.task), entry.priority);
+        Schedule(host, state);
+    }
+}
+
+void Frontier::ForEach(const std::function<void(const UrlTask&)>& visit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto& [host, state] : hosts_) {
+        auto urls = state.urls;
+        for (; !urls.empty(); urls.pop()) {
+            if (!urls.top().task.robots) {
+                visit(urls.top().task);
+            }
+        }
+    }
+
+    for (const auto& entry : spill_) {
+        visit(entry.task);
+    }
+
+    // Остаток сегмента читается вторым потоком с текущей позиции основного
+    for (auto& segment : segments_) {
+        visit(segment->next.task);
+
+        Segment rest;
+        rest.path = segment->path;
+        rest.prev_url = segment->prev_url;
+        rest.file.open(segment->path, std::ios::binary);
+        rest.file.seekg(segment->file.tellg());
+        for (size_t i = 1; i < segment->remaining; ++i) {
+            if (!ReadNext(rest)) {
+                std::cerr << "Cannot read frontier segment: " << segment->path << std::endl;
+                break;
+            }
+            visit(rest.next.task);
+        }
+    }
+}
+
+size_t Frontier::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_size_ + spill_.size() + segment_size_;
+}
+
+Frontier::Stats Frontier::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.memory_urls = memory_size_;
+    stats.spilled_urls = spill_.size() + segment_size_;
+    stats.segments = segments_.size();
+    stats.hosts = hosts_.size();
+    for (const auto& segment : segments_) {
+        stats.segment_bytes += segment->bytes;
+    }
+    return stats;
+}
+
+double Frontier::ParseCrawlDelay(const std::string& robots, const std::string& user_agent) {
+    auto lower = [](std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return s;
+    };
+    auto trim = [](const std::string& s) {
+        size_t begin = s.find_first_not_of(" \t\r");
+        size_t end = s.find_last_not_of(" \t\r");
+        return begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+    };
+
+    // Имя робота без версии: "SearchEngineBot/1.0" -> "searchenginebot"
+    const std::string agent = lower(user_agent.substr(0, user_agent.find('/')));
+
+    double own_delay = -1.0;
+    double any_delay = -1.0;
+    bool group_own = false;
+    bool group_any = false;
+    bool in_agents = false;     // идут подряд строки User-agent одной группы
+
+    size_t pos = 0;
+    while (pos < robots.size()) {
+        size_t end = robots.find('\n', pos);
+        if (end == std::string::npos) end = robots.size();
+        std::string line = robots.substr(pos, end - pos);
+        pos = end + 1;
+
+        line = trim(line.substr(0, line.find('#')));
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        const std::string key = lower(trim(line.substr(0, colon)));
+        const std::string value = trim(line.substr(colon + 1));
+
+        if (key == "user-agent") {
+            if (!in_agents) {
+                group_own = group_any = false;
+                in_agents = true;
+            }
+            const std::string name = lower(value);
+            if (name == "*") group_any = true;
+            else if (!agent.empty() && agent.find(name) != std::string::npos) group_own = true;
+            continue;
+        }
+        in_agents = false;
+
+        if (key == "crawl-delay" && (group_own || group_any)) {
+            double delay = std::strtod(value.c_str(), nullptr);
+            if (delay < 0) continue;
+            if (group_own) own_delay = delay;
+            else any_delay = delay;
+        }
+    }
+
+    return own_delay >= 0 ? own_delay : any_delay;
+}
\ No newline at end of file
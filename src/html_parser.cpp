@@ -7,25 +7,25 @@
 std::string HtmlParser::ExtractText(const std::string& html) {
     std::string text = html;
 
-    //  script  style 
+    // Удаляем script и style теги
     std::regex script_regex("<script[^>]*>.*?</script>", std::regex::icase);
     text = std::regex_replace(text, script_regex, "");
 
     std::regex style_regex("<style[^>]*>.*?</style>", std::regex::icase);
     text = std::regex_replace(text, style_regex, "");
 
-    //  HTML 
+    // Удаляем HTML теги
     std::regex tag_regex("<[^>]*>");
     text = std::regex_replace(text, tag_regex, " ");
 
-    //  HTML entities
+    // Заменяем HTML entities
     std::regex nbsp_regex("&nbsp;");
     text = std::regex_replace(text, nbsp_regex, " ");
 
     std::regex amp_regex("&amp;");
     text = std::regex_replace(text, amp_regex, "&");
 
-    //   
+    // Удаляем множественные пробелы
     std::regex space_regex("\\s+");
     text = std::regex_replace(text, space_regex, " ");
 
@@ -35,7 +35,7 @@ std::string HtmlParser::ExtractText(const std::string& html) {
 std::vector<std::string> HtmlParser::ExtractLinks(const std::string& html, const std::string& base_url) {
     std::vector<std::string> links;
 
-    //  regex   
+    // Простой regex для извлечения ссылок
     std::regex link_regex("<a\\s+[^>]*href=\"([^\"]*)\"[^>]*>", std::regex::icase);
 
     auto words_begin = std::sregex_iterator(html.begin(), html.end(), link_regex);
@@ -45,12 +45,12 @@ std::vector<std::string> HtmlParser::ExtractLinks(const std::string& html, const
         std::smatch match = *i;
         std::string link = match[1].str();
 
-        //     
+        // Пропускаем пустые ссылки и якоря
         if (link.empty() || link[0] == '#') {
             continue;
         }
 
-        //     
+        // Преобразуем относительные ссылки в абсолютные
         if (link.find("http") != 0) {
             if (link[0] == '/') {
                 size_t protocol_end = base_url.find("://");
@@ -98,7 +98,7 @@ std::string HtmlParser::GetPageTitle(const std::string& html) {
         return "";
     }
 
-    title_start += 7; //  "<title>"
+    title_start += 7; // Длина "<title>"
     size_t title_end = html.find("</title>", title_start);
     if (title_end == std::string::npos) {
         return "";
@@ -120,11 +120,11 @@ std::string HtmlParser::CleanText(const std::string& text) {
         }
     }
 
-    //   
+    // Удаляем множественные пробелы
     std::regex space_regex("\\s+");
     cleaned = std::regex_replace(cleaned, space_regex, " ");
 
-    //      
+    // Убираем пробелы в начале и конце
     cleaned.erase(0, cleaned.find_first_not_of(" \t\n\r\f\v"));
     cleaned.erase(cleaned.find_last_not_of(" \t\n\r\f\v") + 1);
 
@@ -136,7 +136,7 @@ bool HtmlParser::IsValidWord(const std::string& word) {
         return false;
     }
 
-    // ,       
+    // Проверяем, что слово состоит в основном из букв
     int letter_count = 0;
     for (char c : word) {
         if (std::isalpha(c)) {
@@ -144,7 +144,7 @@ bool HtmlParser::IsValidWord(const std::string& word) {
         }
     }
 
-    return letter_count >= word.length() * 0.7; //   70% 
+    return letter_count >= word.length() * 0.7; // Хотя бы 70% букв
 }
 
 std::string HtmlParser::ToLower(const std::string& str) {
@@ -155,13 +155,13 @@ std::string HtmlParser::ToLower(const std::string& str) {
 }
 
 std::string HtmlParser::NormalizeUrl(const std::string& url, const std::string& base_url) {
-    //    URL
+    // Простая реализация нормализации URL
     std::string result = url;
 
-    //  URL ,   
+    // Если URL относительный, преобразуем в абсолютный
     if (url.find("://") == std::string::npos) {
         if (!url.empty() && url[0] == '/') {
-            //    
+            // Абсолютный путь относительно домена
             size_t protocol_pos = base_url.find("://");
             if (protocol_pos != std::string::npos) {
                 size_t domain_end = base_url.find('/', protocol_pos + 3);
@@ -175,7 +175,7 @@ std::string HtmlParser::NormalizeUrl(const std::string& url, const std::string&
             }
         }
         else {
-            //  
+            // Относительный путь
             size_t last_slash = base_url.find_last_of('/');
             if (last_slash != std::string::npos) {
                 std::string base_path = base_url.substr(0, last_slash + 1);
@@ -0,0 +1,70 @@
+#include "html_template.h"
+#include <stdexcept>
+
+HtmlTemplate::HtmlTemplate(std::string_view source) {
+    size_t pos = 0;
+
+    while (true) {
+        size_t open = source.find("{{", pos);
+        if (open == std::string_view::npos) {
+            break;
+        }
+        size_t close = source.find("}}", open + 2);
+        if (close == std::string_view::npos) {
+            throw std::invalid_argument("Unterminated placeholder in HTML template");
+        }
+
+        std::string name(source.substr(open + 2, close - open - 2));
+        size_t slot = 0;
+        while (slot < slot_names_.size() && slot_names_[slot] != name) {
+            ++slot;
+        }
+        if (slot == slot_names_.size()) {
+            slot_names_.push_back(name);
+        }
+
+        fragments_.emplace_back(source.substr(pos, open - pos));
+        slots_.push_back(slot);
+        pos = close + 2;
+    }
+
+    fragments_.emplace_back(source.substr(pos));
+
+    for (const auto& fragment : fragments_) {
+        static_size_ += fragment.size();
+    }
+}
+
+void HtmlTemplate::Render(std::string& out, std::initializer_list<std::string_view> values) const {
+    if (values.size() != slot_names_.size()) {
+        throw std::invalid_argument("HTML template expects " + std::to_string(slot_names_.size()) + " values");
+    }
+
+    const std::string_view* value = values.begin();
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        out += fragments_[i];
+        AppendEscaped(out, value[slots_[i]]);
+    }
+    out += fragments_.back();
+}
+
+void HtmlTemplate::AppendEscaped(std::string& out, std::string_view value) {
+    // Безопасные участки копируются одним append, заменяются только спецсимволы
+    size_t run_start = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        const char* entity;
+        switch (value[i]) {
+        case '&': entity = "&amp;"; break;
+        case '<': entity = "&lt;"; break;
+        case '>': entity = "&gt;"; break;
+        case '"': entity = "&quot;"; break;
+        case '\'': entity = "&#39;"; break;
+        default: continue;
+        }
+
+        out.append(value.data() + run_start, i - run_start);
+        out += entity;
+        run_start = i + 1;
+    }
+    out.append(value.data() + run_start, value.size() - run_start);
+}
@@ -1,163 +1,618 @@
 #include "http_client.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <regex>
+#include <type_traits>
+
+// Цепочка асинхронных шагов одной загрузки. Объект живет, пока на него
+// ссылаются незавершенные операции (shared_from_this в обработчиках).
+template <class Stream>
+class HttpClient::Fetch : public std::enable_shared_from_this<HttpClient::Fetch<Stream>> {
+public:
+    static constexpr bool kUseSsl = std::is_same_v<Stream, SslStream>;
+
+    Fetch(HttpClient& client, std::string url, std::string host, std::string port,
+        std::string target, RequestOptions options, DownloadHandler handler)
+        : client_(client),
+          url_(std::move(url)),
+          host_(std::move(host)),
+          port_(std::move(port)),
+          target_(std::move(target)),
+          pool_key_((kUseSsl ? "https://" : "http://") + host_ + ":" + port_),
+          options_(std::move(options)),
+          handler_(std::move(handler)) {
+    }
 
-HttpClient::HttpClient()
-    : ssl_ctx_(ssl::context::tlsv12_client) {
-    //  SSL 
-    ssl_ctx_.set_default_verify_paths();
-    ssl_ctx_.set_verify_mode(ssl::verify_none); //     
-}
+    void Run() {
+        // Сначала пробуем простаивающее keep-alive соединение с этим хостом
+        stream_ = client_.PoolFor<Stream>().Acquire(pool_key_);
+        if (stream_) {
+            reused_ = true;
+            Write();
+            return;
+        }
+        Connect();
+    }
 
-HttpClient::~HttpClient() {
-    //   -
-    if (!ioc_.stopped()) {
-        ioc_.stop();
+private:
+    void Connect() {
+        setup_start_ = std::chrono::steady_clock::now();
+        client_.context_->GetDnsCache().AsyncResolve(host_, port_, client_.ioc_.get_executor(),
+            beast::bind_front_handler(&Fetch::OnResolve, this->shared_from_this()));
     }
-}
 
-HttpClient::HttpResponse HttpClient::DownloadPage(const std::string& url) {
-    HttpResponse response;
+    void OnResolve(beast::error_code ec, tcp::resolver::results_type results) {
+        if (ec) {
+            Fail(ec, "resolve");
+            return;
+        }
 
-    try {
-        std::string host, port, target;
-        std::string resolved_url = ResolveUrl(url, host, port, target);
+        if constexpr (kUseSsl) {
+            stream_ = std::make_unique<Stream>(client_.ioc_, client_.context_->GetSslContext());
+            // Устанавливаем SNI Hostname (важно для HTTPS)
+            if (!SSL_set_tlsext_host_name(stream_->native_handle(), host_.c_str())) {
+                Fail(beast::error_code(static_cast<int>(::ERR_get_error()), net::error::get_ssl_category()), "sni");
+                return;
+            }
+            // Повторный handshake с хостом по сохраненной сессии занимает один RTT
+            client_.context_->PrepareTlsResumption(stream_->native_handle(), host_);
+        }
+        else {
+            stream_ = std::make_unique<Stream>(client_.ioc_);
+        }
 
-        if (resolved_url.empty()) {
-            response.status_code = 400;
-            std::cerr << "Invalid URL: " << url << std::endl;
-            return response;
+        // Таймаут действует на каждый шаг, включая connect и handshake
+        beast::get_lowest_layer(*stream_).expires_after(std::chrono::seconds(client_.timeout_));
+        beast::get_lowest_layer(*stream_).async_connect(results,
+            beast::bind_front_handler(&Fetch::OnConnect, this->shared_from_this()));
+    }
+
+    void OnConnect(beast::error_code ec, const tcp::endpoint&) {
+        if (ec) {
+            Fail(ec, "connect");
+            return;
         }
 
-        std::cout << "Downloading: " << url << " (host: " << host << ", port: " << port << ", target: " << target << ")" << std::endl;
+        if constexpr (kUseSsl) {
+            beast::get_lowest_layer(*stream_).expires_after(std::chrono::seconds(client_.timeout_));
+            stream_->async_handshake(ssl::stream_base::client,
+                beast::bind_front_handler(&Fetch::OnHandshake, this->shared_from_this()));
+        }
+        else {
+            OnHandshake({});
+        }
+    }
 
-        //  
-        tcp::resolver resolver(ioc_);
+    void OnHandshake(beast::error_code ec) {
+        if (ec) {
+            Fail(ec, "handshake");
+            return;
+        }
+        if constexpr (kUseSsl) {
+            client_.context_->RecordHandshake(stream_->native_handle());
+        }
+        client_.RecordSetup(pool_key_,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - setup_start_).count());
+        Write();
+    }
 
-        //  
-        auto const results = resolver.resolve(host, port);
+    void Write() {
+        // Создаем HTTP GET запрос
+        request_ = { http::verb::get, target_, 11 };
+        request_.set(http::field::host, host_);
+        request_.set(http::field::user_agent, client_.user_agent_);
+        request_.set(http::field::accept, "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8");
+        request_.set(http::field::accept_encoding, "gzip, deflate");
+        if (!options_.validators.etag.empty()) {
+            request_.set(http::field::if_none_match, options_.validators.etag);
+        }
+        if (!options_.validators.last_modified.empty()) {
+            request_.set(http::field::if_modified_since, options_.validators.last_modified);
+        }
 
-        //  
-        bool use_ssl = (port == "443" || url.find("https://") == 0);
+        beast::get_lowest_layer(*stream_).expires_after(std::chrono::seconds(client_.timeout_));
+        http::async_write(*stream_, request_,
+            beast::bind_front_handler(&Fetch::OnWrite, this->shared_from_this()));
+    }
 
-        if (use_ssl) {
-            // SSL 
-            beast::ssl_stream<beast::tcp_stream> stream(ioc_, ssl_ctx_);
+    void OnWrite(beast::error_code ec, std::size_t) {
+        if (ec) {
+            if (RetryStale(ec)) return;
+            Fail(ec, "write");
+            return;
+        }
+        parser_.emplace();
+        // Предел тела проверяется в StartBody и ConsumeBody: ошибка body_limit
+        // из парсера пришла бы раньше статуса и заголовков. Не boost::none:
+        // в Boost 1.74 с ним любое тело с Content-Length считается превышением
+        parser_->body_limit(std::numeric_limits<std::uint64_t>::max());
+
+        // Сначала только заголовки: по ним решается, читать ли тело вообще
+        beast::get_lowest_layer(*stream_).expires_after(std::chrono::seconds(client_.timeout_));
+        http::async_read_header(*stream_, buffer_, *parser_,
+            beast::bind_front_handler(&Fetch::OnReadHeader, this->shared_from_this()));
+    }
 
-            //  SNI Hostname (  HTTPS)
-            if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
-                beast::error_code ec{ static_cast<int>(::ERR_get_error()), net::error::get_ssl_category() };
-                throw beast::system_error{ ec };
-            }
+    void OnReadHeader(beast::error_code ec, std::size_t) {
+        if (ec) {
+            if (RetryStale(ec)) return;
+            Fail(ec, "read");
+            return;
+        }
 
-            //  TCP 
-            beast::get_lowest_layer(stream).connect(results);
+        if (!StartBody()) {
+            return;
+        }
+        // У 304 и пустых ответов тела нет, распаковщик им не нужен
+        if (parser_->is_done()) {
+            Finish();
+            return;
+        }
+        if (!StartDecoding()) {
+            return;
+        }
+        ReadSome();
+    }
 
-            //  SSL handshake
-            stream.handshake(ssl::stream_base::client);
+    // Тело читается кусками в chunk_ и сразу уходит в результат (или в
+    // распаковщик), не собираясь целиком в промежуточном буфере
+    void ReadSome() {
+        auto& body = parser_->get().body();
+        body.data = chunk_.data();
+        body.size = chunk_.size();
+        http::async_read(*stream_, buffer_, *parser_,
+            beast::bind_front_handler(&Fetch::OnRead, this->shared_from_this()));
+    }
 
-            //  
-            beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(timeout_));
+    void OnRead(beast::error_code ec, std::size_t) {
+        // need_buffer - кусок заполнен, а не ошибка
+        if (ec == http::error::need_buffer) {
+            ec = {};
+        }
+        if (ec) {
+            Fail(ec, "read");
+            return;
+        }
 
-            //  HTTP GET 
-            http::request<http::string_body> req{ http::verb::get, target, 11 };
-            req.set(http::field::host, host);
-            req.set(http::field::user_agent, user_agent_);
-            req.set(http::field::accept, "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8");
+        const size_t received = chunk_.size() - parser_->get().body().size;
+        if (received > 0 && !ConsumeBody(std::string_view(chunk_.data(), received))) {
+            return;
+        }
+        if (!parser_->is_done()) {
+            ReadSome();
+            return;
+        }
+        Finish();
+    }
 
-            //  HTTP 
-            http::write(stream, req);
+    // Ответ прочитан целиком
+    void Finish() {
+        if (decompressor_ && result_.transfer_size > 0 && !decompressor_->Finished()) {
+            Reject("truncated compressed body");
+            return;
+        }
 
-            //  
-            beast::flat_buffer buffer;
-            http::response<http::dynamic_body> res;
+        // Попадание в пул засчитывается, только если соединение действительно сработало
+        if (reused_) {
+            client_.RecordReuse(pool_key_);
+        }
 
-            //  
-            http::read(stream, buffer, res);
+        std::cout << "Successfully downloaded " << url_ << " (" << result_.content.size()
+            << " bytes, " << result_.transfer_size << " transferred, status: " << result_.status_code << ")" << std::endl;
+
+        // Ответ прочитан целиком и сервер не закрывает соединение: оставляем его
+        // для следующих запросов к этому хосту
+        const auto& response = parser_->get();
+        if (response.keep_alive() && !response.need_eof() && buffer_.size() == 0) {
+            beast::get_lowest_layer(*stream_).expires_never();
+            client_.PoolFor<Stream>().Release(pool_key_, std::move(stream_));
+            Complete();
+            return;
+        }
+        Shutdown();
+    }
 
-            //   
-            response.status_code = res.result_int();
+    // Заголовки прочитаны, тело еще нет: статус, валидаторы и решение, читать ли тело.
+    // false - тело читать не нужно, загрузка уже завершена
+    bool StartBody() {
+        const auto& response = parser_->get();
+        result_.status_code = response.result_int();
+        auto content_type = response.find(http::field::content_type);
+        if (content_type != response.end()) {
+            result_.content_type = std::string(content_type->value());
+        }
+        auto etag = response.find(http::field::etag);
+        if (etag != response.end()) {
+            result_.etag = std::string(etag->value());
+        }
+        auto last_modified = response.find(http::field::last_modified);
+        if (last_modified != response.end()) {
+            result_.last_modified = std::string(last_modified->value());
+        }
 
-            //     
-            response.content = beast::buffers_to_string(res.body().data());
+        // Решаем по заголовкам, нужно ли тело вообще: ссылка на ISO или видео
+        // не должна скачиваться целиком только затем, чтобы быть отброшенной
+        if (options_.html_only && result_.status_code == 200 && !IsHtml(result_.content_type)) {
+            Skip("not HTML (" + (result_.content_type.empty() ? std::string("no Content-Type") : result_.content_type) + ")");
+            return false;
+        }
+        if (parser_->content_length() && *parser_->content_length() > client_.max_body_size_) {
+            Skip("Content-Length " + std::to_string(*parser_->content_length()) + " exceeds " +
+                std::to_string(client_.max_body_size_) + " bytes");
+            return false;
+        }
+        return true;
+    }
 
-            //  Content-Type
-            auto content_type = res.find(http::field::content_type);
-            if (content_type != res.end()) {
-                response.content_type = content_type->value();
+    // Распаковщик выбирается по Content-Encoding до первого чтения тела,
+    // так что через него проходит тело с первого байта
+    bool StartDecoding() {
+        const auto& response = parser_->get();
+        ContentEncoding encoding = ContentEncoding::Identity;
+        auto content_encoding = response.find(http::field::content_encoding);
+        if (content_encoding != response.end() && !ParseContentEncoding(
+            std::string_view(content_encoding->value().data(), content_encoding->value().size()), encoding)) {
+            Reject("unsupported Content-Encoding: " + std::string(content_encoding->value()));
+            return false;
+        }
+        if (encoding != ContentEncoding::Identity) {
+            decompressor_ = client_.AcquireDecompressor(encoding);
+            if (!decompressor_) {
+                Reject("cannot initialize zlib");
+                return false;
             }
+        }
+        else if (parser_->content_length()) {
+            result_.content.reserve(static_cast<size_t>(*parser_->content_length()));
+        }
+        return true;
+    }
 
-            // Gracefully close the SSL stream
-            beast::error_code ec;
-            stream.shutdown(ec);
+    bool ConsumeBody(std::string_view data) {
+        // Без Content-Length (chunked) размер выясняется только по ходу чтения
+        if (result_.transfer_size + data.size() > client_.max_body_size_) {
+            Skip("body exceeds " + std::to_string(client_.max_body_size_) + " bytes");
+            return false;
+        }
+        result_.transfer_size += data.size();
+        if (!decompressor_) {
+            result_.content.append(data.data(), data.size());
+            return true;
+        }
+        if (!decompressor_->Feed(data, result_.content)) {
+            Reject(decompressor_->LimitExceeded()
+                ? "decompressed body exceeds " + std::to_string(client_.max_decompressed_size_) + " bytes"
+                : std::string("corrupt compressed body"));
+            return false;
+        }
+        return true;
+    }
 
-            // SSL shutdown   ,  
-            if (ec == net::error::eof || ec == ssl::error::stream_truncated) {
-                ec = {};
-            }
-            if (ec && ec != beast::errc::not_connected) {
-                std::cerr << "Error shutting down SSL stream: " << ec.message() << std::endl;
-            }
+    // Сервер мог закрыть простаивавшее соединение, пока оно лежало в пуле.
+    // GET можно безопасно повторить, один раз и уже по новому соединению.
+    // Вызывается только до разбора заголовков ответа.
+    bool RetryStale(beast::error_code ec) {
+        if (!reused_) {
+            return false;
+        }
+        if (ec != http::error::end_of_stream && ec != net::error::eof &&
+            ec != net::error::connection_reset && ec != net::error::broken_pipe &&
+            ec != net::error::connection_aborted && ec != ssl::error::stream_truncated) {
+            return false;
+        }
 
+        reused_ = false;
+        stream_.reset();
+        buffer_.clear();
+        parser_.reset();
+        Connect();
+        return true;
+    }
+
+    void Shutdown() {
+        if constexpr (kUseSsl) {
+            // SSL shutdown может зависнуть на сервере, который не отвечает close_notify
+            beast::get_lowest_layer(*stream_).expires_after(std::chrono::seconds(5));
+            stream_->async_shutdown(
+                beast::bind_front_handler(&Fetch::OnShutdown, this->shared_from_this()));
         }
         else {
-            //  HTTP 
-            beast::tcp_stream stream(ioc_);
+            beast::error_code ec;
+            stream_->socket().shutdown(tcp::socket::shutdown_both, ec);
+            OnShutdown(ec);
+        }
+    }
+
+    void OnShutdown(beast::error_code ec) {
+        // SSL shutdown может возвращать ошибку, это нормально
+        if (ec && ec != net::error::eof && ec != ssl::error::stream_truncated &&
+            ec != beast::errc::not_connected && ec != beast::error::timeout) {
+            std::cerr << "Error shutting down connection to " << host_ << ": " << ec.message() << std::endl;
+        }
+        Complete();
+    }
+
+    void Fail(beast::error_code ec, const char* what) {
+        std::cerr << "HTTP Client Error downloading " << url_ << " (" << what << "): " << ec.message() << std::endl;
+        result_ = {};
+        result_.status_code = 500;
+        Complete();
+    }
 
-            //  
-            stream.connect(results);
+    // Тело намеренно не дочитано; статус и заголовки остаются в результате,
+    // а соединение закрывается вместе с загрузкой
+    void Skip(const std::string& reason) {
+        std::cout << "Skipped body of " << url_ << ": " << reason << std::endl;
+        result_.content.clear();
+        result_.skip_reason = reason;
+        Complete();
+    }
 
-            //  
-            stream.expires_after(std::chrono::seconds(timeout_));
+    // Ответ пришел, но использовать его нельзя; недочитанное соединение
+    // в пул не возвращается и закрывается вместе с загрузкой
+    void Reject(const std::string& reason) {
+        std::cerr << "HTTP Client rejected " << url_ << ": " << reason << std::endl;
+        result_ = {};
+        result_.status_code = 500;
+        Complete();
+    }
 
-            //  HTTP GET 
-            http::request<http::string_body> req{ http::verb::get, target, 11 };
-            req.set(http::field::host, host);
-            req.set(http::field::user_agent, user_agent_);
-            req.set(http::field::accept, "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8");
+    void Complete() {
+        if (decompressor_) {
+            client_.ReleaseDecompressor(std::move(decompressor_));
+        }
+        if (handler_) {
+            auto handler = std::move(handler_);
+            handler_ = nullptr;
+            handler(std::move(result_));
+        }
+    }
 
-            //  HTTP 
-            http::write(stream, req);
+    HttpClient& client_;
+    std::unique_ptr<Stream> stream_;
+    std::string url_;
+    std::string host_;
+    std::string port_;
+    std::string target_;
+    std::string pool_key_;
+    RequestOptions options_;
+    DownloadHandler handler_;
+    bool reused_ = false;
+    std::chrono::steady_clock::time_point setup_start_;
+
+    http::request<http::empty_body> request_;
+    beast::flat_buffer buffer_;
+    std::optional<http::response_parser<http::buffer_body>> parser_;
+    std::array<char, 16 * 1024> chunk_;
+    std::unique_ptr<Decompressor> decompressor_;
+    HttpResponse result_;
+};
+
+template <>
+ConnectionPool<HttpClient::PlainStream>& HttpClient::PoolFor<HttpClient::PlainStream>() {
+    return plain_pool_;
+}
 
-            //  
-            beast::flat_buffer buffer;
-            http::response<http::dynamic_body> res;
+template <>
+ConnectionPool<HttpClient::SslStream>& HttpClient::PoolFor<HttpClient::SslStream>() {
+    return ssl_pool_;
+}
 
-            //  
-            http::read(stream, buffer, res);
+namespace {
 
-            //   
-            response.status_code = res.result_int();
+// Индекс, под которым в SSL_CTX хранится указатель на владеющий HttpClientContext
+int ContextExDataIndex() {
+    static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
 
-            //     
-            response.content = beast::buffers_to_string(res.body().data());
+} // namespace
 
-            //  Content-Type
-            auto content_type = res.find(http::field::content_type);
-            if (content_type != res.end()) {
-                response.content_type = content_type->value();
-            }
+HttpClientContext::HttpClientContext()
+    : ssl_ctx_(ssl::context::tls_client) {
+    // Настройка SSL контекста: TLS 1.2 и новее
+    ssl_ctx_.set_options(ssl::context::default_workarounds | ssl::context::no_sslv2 |
+        ssl::context::no_sslv3 | ssl::context::no_tlsv1 | ssl::context::no_tlsv1_1);
+    ssl_ctx_.set_default_verify_paths();
+    ssl_ctx_.set_verify_mode(ssl::verify_none); // Для тестирования отключаем проверку сертификатов
 
-            // Gracefully close the socket
-            beast::error_code ec;
-            stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+    // Клиентский кэш сессий ведем сами: встроенный в OpenSSL ищет сессии только на сервере
+    SSL_CTX* native = ssl_ctx_.native_handle();
+    SSL_CTX_set_ex_data(native, ContextExDataIndex(), this);
+    SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(native, &HttpClientContext::OnNewSession);
+}
 
-            if (ec && ec != beast::errc::not_connected) {
-                std::cerr << "Error shutting down socket: " << ec.message() << std::endl;
-            }
-        }
+HttpClientContext::~HttpClientContext() {
+    for (auto& entry : tls_sessions_) {
+        SSL_SESSION_free(entry.second);
+    }
+}
+
+int HttpClientContext::OnNewSession(SSL* ssl, SSL_SESSION* session) {
+    auto* context = static_cast<HttpClientContext*>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ContextExDataIndex()));
+    const char* host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+    if (!context || !host) {
+        return 0;
+    }
+    // 1 - сессия остается за нами, OpenSSL не освобождает ее
+    context->StoreTlsSession(host, session);
+    return 1;
+}
 
-        std::cout << "Successfully downloaded " << url << " (" << response.content.size() << " bytes, status: " << response.status_code << ")" << std::endl;
+void HttpClientContext::StoreTlsSession(const std::string& host, SSL_SESSION* session) {
+    std::lock_guard<std::mutex> lock(tls_mutex_);
 
+    auto it = tls_session_index_.find(host);
+    if (it != tls_session_index_.end()) {
+        SSL_SESSION_free(it->second->second);
+        tls_sessions_.erase(it->second);
+        tls_session_index_.erase(it);
     }
-    catch (const std::exception& e) {
-        std::cerr << "HTTP Client Error downloading " << url << ": " << e.what() << std::endl;
-        response.status_code = 500;
+    else if (tls_sessions_.size() >= kMaxTlsSessions) {
+        SSL_SESSION_free(tls_sessions_.back().second);
+        tls_session_index_.erase(tls_sessions_.back().first);
+        tls_sessions_.pop_back();
+    }
+
+    tls_sessions_.emplace_front(host, session);
+    tls_session_index_[host] = tls_sessions_.begin();
+}
+
+void HttpClientContext::PrepareTlsResumption(SSL* ssl, const std::string& host) {
+    std::lock_guard<std::mutex> lock(tls_mutex_);
+    auto it = tls_session_index_.find(host);
+    if (it == tls_session_index_.end()) {
+        return;
     }
+    // SSL_set_session берет свою ссылку на сессию, кэш сохраняет свою
+    SSL_set_session(ssl, it->second->second);
+    tls_sessions_.splice(tls_sessions_.begin(), tls_sessions_, it->second);
+}
 
+void HttpClientContext::RecordHandshake(SSL* ssl) {
+    tls_handshakes_.fetch_add(1, std::memory_order_relaxed);
+    if (SSL_session_reused(ssl)) {
+        tls_resumed_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+HttpClientContext::TlsStats HttpClientContext::GetTlsStats() const {
+    TlsStats stats;
+    stats.handshakes = tls_handshakes_.load(std::memory_order_relaxed);
+    stats.resumed = tls_resumed_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+HttpClient::HttpClient()
+    : HttpClient(std::make_shared<HttpClientContext>()) {
+}
+
+HttpClient::HttpClient(std::shared_ptr<HttpClientContext> context)
+    : context_(std::move(context)) {
+}
+
+HttpClient::~HttpClient() {
+    // Очищаем контекст ввода-вывода
+    if (!ioc_.stopped()) {
+        ioc_.stop();
+    }
+}
+
+void HttpClient::SetPoolLimits(int max_idle_per_host, int idle_timeout) {
+    const auto per_host = static_cast<size_t>(std::max(max_idle_per_host, 0));
+    const auto timeout = std::chrono::seconds(std::max(idle_timeout, 1));
+    plain_pool_.SetLimits(per_host, timeout);
+    ssl_pool_.SetLimits(per_host, timeout);
+}
+
+HttpClient::PoolStats HttpClient::GetPoolStats() const {
+    PoolStats stats;
+    stats.hits = pool_hits_.load(std::memory_order_relaxed);
+    stats.misses = pool_misses_.load(std::memory_order_relaxed);
+    stats.setup_seconds = setup_micros_.load(std::memory_order_relaxed) / 1e6;
+    stats.saved_seconds = saved_micros_.load(std::memory_order_relaxed) / 1e6;
+    return stats;
+}
+
+void HttpClient::RecordSetup(const std::string& key, double seconds) {
+    pool_misses_.fetch_add(1, std::memory_order_relaxed);
+    setup_micros_.fetch_add(static_cast<uint64_t>(seconds * 1e6), std::memory_order_relaxed);
+
+    // Скользящее среднее: оценка того, сколько стоило бы новое соединение с хостом
+    auto [it, inserted] = setup_seconds_.try_emplace(key, seconds);
+    if (!inserted) {
+        it->second = it->second * 0.8 + seconds * 0.2;
+    }
+}
+
+void HttpClient::RecordReuse(const std::string& key) {
+    pool_hits_.fetch_add(1, std::memory_order_relaxed);
+    auto it = setup_seconds_.find(key);
+    if (it != setup_seconds_.end()) {
+        saved_micros_.fetch_add(static_cast<uint64_t>(it->second * 1e6), std::memory_order_relaxed);
+    }
+}
+
+std::unique_ptr<Decompressor> HttpClient::AcquireDecompressor(ContentEncoding encoding) {
+    std::unique_ptr<Decompressor> decompressor;
+    if (!idle_decompressors_.empty()) {
+        decompressor = std::move(idle_decompressors_.back());
+        idle_decompressors_.pop_back();
+    }
+    else {
+        decompressor = std::make_unique<Decompressor>(max_decompressed_size_);
+    }
+
+    decompressor->SetMaxOutput(max_decompressed_size_);
+    if (!decompressor->Reset(encoding)) {
+        return nullptr;
+    }
+    return decompressor;
+}
+
+void HttpClient::ReleaseDecompressor(std::unique_ptr<Decompressor> decompressor) {
+    // Около 40 КБ состояния zlib на каждый; больше, чем одновременных
+    // сжатых загрузок обычно бывает, держать незачем
+    if (idle_decompressors_.size() < 16) {
+        idle_decompressors_.push_back(std::move(decompressor));
+    }
+}
+
+void HttpClient::AsyncDownload(const std::string& url, DownloadHandler handler) {
+    AsyncDownload(url, RequestOptions{}, std::move(handler));
+}
+
+void HttpClient::AsyncDownload(const std::string& url, const RequestOptions& options, DownloadHandler handler) {
+    std::string host, port, target;
+    std::string resolved_url = ResolveUrl(url, host, port, target);
+
+    if (resolved_url.empty()) {
+        std::cerr << "Invalid URL: " << url << std::endl;
+        // Обработчик всегда вызывается асинхронно, даже при ошибке разбора URL
+        net::post(ioc_, [handler = std::move(handler)]() {
+            HttpResponse response;
+            response.status_code = 400;
+            handler(std::move(response));
+        });
+        return;
+    }
+
+    std::cout << "Downloading: " << url << " (host: " << host << ", port: " << port << ", target: " << target << ")" << std::endl;
+
+    // Определяем протокол
+    bool use_ssl = (port == "443" || url.find("https://") == 0);
+    if (use_ssl) {
+        std::make_shared<Fetch<SslStream>>(*this, url, host, port, target, options, std::move(handler))->Run();
+    }
+    else {
+        std::make_shared<Fetch<PlainStream>>(*this, url, host, port, target, options, std::move(handler))->Run();
+    }
+}
+
+HttpClient::HttpResponse HttpClient::DownloadPage(const std::string& url) {
+    HttpResponse response;
+    ioc_.restart();
+    AsyncDownload(url, [&response](HttpResponse result) {
+        response = std::move(result);
+    });
+    ioc_.run();
     return response;
 }
 
+bool HttpClient::IsHtml(const std::string& content_type) {
+    std::string lower = content_type;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower.find("text/html") != std::string::npos || lower.find("application/xhtml+xml") != std::string::npos;
+}
+
 bool HttpClient::IsValidUrl(const std::string& url) {
     try {
         std::regex url_regex(
@@ -200,7 +655,7 @@ std::string HttpClient::ResolveUrl(const std::string& url, std::string& host, st
             return url;
         }
 
-        //  URL   ( http  )
+        // Проверяем URL без протокола (добавляем http по умолчанию)
         std::regex no_protocol_regex(
             R"(^([\w-]+\.)+[\w-]+(/[\w\-./?%&=]*)?$)",
             std::regex::icase
@@ -0,0 +1,244 @@
+#include "json.h"
+#include <charconv>
+#include <cmath>
+
+void JsonWriter::BeginObject() {
+    BeforeValue();
+    out_ += '{';
+    if (depth_ < kMaxDepth - 1) ++depth_;
+    has_items_[depth_] = false;
+}
+
+void JsonWriter::EndObject() {
+    out_ += '}';
+    if (depth_ > 0) --depth_;
+}
+
+void JsonWriter::BeginArray() {
+    BeforeValue();
+    out_ += '[';
+    if (depth_ < kMaxDepth - 1) ++depth_;
+    has_items_[depth_] = false;
+}
+
+void JsonWriter::EndArray() {
+    out_ += ']';
+    if (depth_ > 0) --depth_;
+}
+
+void JsonWriter::Key(std::string_view key) {
+    BeforeValue();
+    AppendEscaped(out_, key);
+    out_ += ':';
+    after_key_ = true;
+}
+
+void JsonWriter::String(std::string_view value) {
+    BeforeValue();
+    AppendEscaped(out_, value);
+}
+
+void JsonWriter::Int(int64_t value) {
+    BeforeValue();
+    char buf[24];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+    out_.append(buf, end);
+}
+
+void JsonWriter::Double(double value, int precision) {
+    BeforeValue();
+    // NaN и бесконечность в JSON не представимы
+    if (!std::isfinite(value)) {
+        out_ += "null";
+        return;
+    }
+
+    // to_chars не зависит от локали: snprintf при десятичной запятой выдал бы "0,5"
+    char buf[64];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, precision);
+    if (result.ec != std::errc()) {
+        // Слишком длинное в фиксированной записи число пишется в экспоненциальной
+        result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general);
+    }
+    out_.append(buf, result.ptr);
+}
+
+void JsonWriter::Bool(bool value) {
+    BeforeValue();
+    out_ += value ? "true" : "false";
+}
+
+void JsonWriter::Null() {
+    BeforeValue();
+    out_ += "null";
+}
+
+void JsonWriter::BeforeValue() {
+    // Значение сразу после ключа не требует запятой
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (has_items_[depth_]) {
+        out_ += ',';
+    }
+    has_items_[depth_] = true;
+}
+
+void JsonWriter::AppendEscaped(std::string& out, std::string_view value) {
+    static const char hex[] = "0123456789abcdef";
+
+    out += '"';
+
+    // Копируем непрерывные участки без спецсимволов одним append
+    size_t run_start = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        out.append(value.data() + run_start, i - run_start);
+        run_start = i + 1;
+
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        default:
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 0x0F];
+            break;
+        }
+    }
+    out.append(value.data() + run_start, value.size() - run_start);
+
+    out += '"';
+}
+
+namespace {
+
+void SkipSpaces(std::string_view json, size_t& pos) {
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\n' || json[pos] == '\r')) {
+        ++pos;
+    }
+}
+
+void AppendUtf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    }
+    else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+bool ParseHex4(std::string_view json, size_t pos, uint32_t& code) {
+    if (pos + 4 > json.size()) return false;
+    auto [end, ec] = std::from_chars(json.data() + pos, json.data() + pos + 4, code, 16);
+    return ec == std::errc() && end == json.data() + pos + 4;
+}
+
+// pos указывает на открывающую кавычку; после разбора - на символ за закрывающей
+bool ParseString(std::string_view json, size_t& pos, std::string& out) {
+    ++pos;
+    while (pos < json.size()) {
+        char c = json[pos++];
+        if (c == '"') {
+            return true;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) {
+            return false;
+        }
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+
+        if (pos >= json.size()) return false;
+        char escape = json[pos++];
+        switch (escape) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+            uint32_t code = 0;
+            if (!ParseHex4(json, pos, code)) return false;
+            pos += 4;
+            // Суррогатная пара: символ за пределами BMP
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                uint32_t low = 0;
+                if (pos + 6 > json.size() || json[pos] != '\\' || json[pos + 1] != 'u' ||
+                    !ParseHex4(json, pos + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                    return false;
+                }
+                pos += 6;
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            AppendUtf8(out, code);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool ParseJsonStringArray(std::string_view json, std::vector<std::string>& out) {
+    size_t pos = 0;
+    SkipSpaces(json, pos);
+    if (pos >= json.size() || json[pos] != '[') return false;
+    ++pos;
+
+    SkipSpaces(json, pos);
+    if (pos < json.size() && json[pos] == ']') {
+        ++pos;
+    }
+    else {
+        while (true) {
+            SkipSpaces(json, pos);
+            if (pos >= json.size() || json[pos] != '"') return false;
+
+            std::string value;
+            if (!ParseString(json, pos, value)) return false;
+            out.push_back(std::move(value));
+
+            SkipSpaces(json, pos);
+            if (pos >= json.size()) return false;
+            if (json[pos] == ']') {
+                ++pos;
+                break;
+            }
+            if (json[pos] != ',') return false;
+            ++pos;
+        }
+    }
+
+    SkipSpaces(json, pos);
+    return pos == json.size();
+}
@@ -0,0 +1,159 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+LatencyHistogram::LatencyHistogram()
+    : counts_(kSubBucketCount + kMaxShift * kSubBucketHalfCount, 0) {
+}
+
+// Значения меньше kSubBucketCount хранятся точно. Для больших берется сдвиг,
+// при котором value >> shift попадает в верхнюю половину подкорзин [1024, 2048):
+// на каждую следующую степень двойки приходится еще 1024 корзины.
+size_t LatencyHistogram::IndexOf(uint64_t value) {
+    if (value < kSubBucketCount) {
+        return static_cast<size_t>(value);
+    }
+    int shift = 0;
+    while ((value >> shift) >= kSubBucketCount) {
+        ++shift;
+    }
+    return static_cast<size_t>(kSubBucketCount + (shift - 1) * kSubBucketHalfCount +
+        ((value >> shift) - kSubBucketHalfCount));
+}
+
+uint64_t LatencyHistogram::LowestValueAt(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    const uint64_t offset = index - kSubBucketCount;
+    const int shift = static_cast<int>(offset / kSubBucketHalfCount) + 1;
+    return (kSubBucketHalfCount + offset % kSubBucketHalfCount) << shift;
+}
+
+uint64_t LatencyHistogram::HighestValueAt(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    const int shift = static_cast<int>((index - kSubBucketCount) / kSubBucketHalfCount) + 1;
+    return LowestValueAt(index) + (1ull << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t micros) {
+    micros = std::min(micros, kMaxValue);
+    ++counts_[IndexOf(micros)];
+    ++total_count_;
+    min_ = std::min(min_, micros);
+    max_ = std::max(max_, micros);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+double LatencyHistogram::Mean() const {
+    if (total_count_ == 0) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i]) {
+            // Середина корзины, как в HdrHistogram
+            sum += counts_[i] * ((LowestValueAt(i) + HighestValueAt(i)) / 2.0);
+        }
+    }
+    return sum / total_count_;
+}
+
+double LatencyHistogram::StdDev() const {
+    if (total_count_ == 0) {
+        return 0.0;
+    }
+    const double mean = Mean();
+    double sum = 0.0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i]) {
+            const double deviation = (LowestValueAt(i) + HighestValueAt(i)) / 2.0 - mean;
+            sum += counts_[i] * deviation * deviation;
+        }
+    }
+    return std::sqrt(sum / total_count_);
+}
+
+uint64_t LatencyHistogram::ValueAtPercentile(double percentile) const {
+    if (total_count_ == 0) {
+        return 0;
+    }
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    const uint64_t target = std::max<uint64_t>(1,
+        static_cast<uint64_t>(std::ceil(percentile / 100.0 * total_count_)));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::min(HighestValueAt(i), max_);
+        }
+    }
+    return max_;
+}
+
+void LatencyHistogram::PrintPercentileDistribution(std::ostream& out, int ticks_per_half_distance) const {
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+
+    out << std::setw(12) << "Value(ms)" << " " << std::setw(14) << "Percentile" << " "
+        << std::setw(10) << "TotalCount" << " " << std::setw(14) << "1/(1-Percentile)" << "\n\n";
+    out << std::fixed;
+
+    if (total_count_ > 0) {
+        ticks_per_half_distance = std::max(ticks_per_half_distance, 1);
+        uint64_t seen = 0;
+        size_t index = 0;
+        double percentile = 0.0;
+
+        while (true) {
+            // Доходим до корзины, закрывающей текущий перцентиль
+            const uint64_t target = std::max<uint64_t>(1,
+                static_cast<uint64_t>(std::ceil(percentile / 100.0 * total_count_)));
+            while (seen < target && index < counts_.size()) {
+                seen += counts_[index++];
+            }
+            const uint64_t value = index ? std::min(HighestValueAt(index - 1), max_) : 0;
+            const double fraction = static_cast<double>(seen) / total_count_;
+
+            out << std::setw(12) << std::setprecision(3) << value / 1000.0 << " "
+                << std::setw(14) << std::setprecision(12) << fraction << " "
+                << std::setw(10) << seen << " ";
+            if (fraction < 1.0) {
+                out << std::setw(14) << std::setprecision(2) << 1.0 / (1.0 - fraction);
+            }
+            out << "\n";
+
+            if (seen >= total_count_) {
+                break;
+            }
+
+            // Как в HdrHistogram: число шагов удваивается на каждой половине
+            // оставшегося до 100% расстояния
+            const double remaining = 100.0 - percentile;
+            const double halvings = std::floor(std::log2(100.0 / remaining)) + 1;
+            const double ticks = ticks_per_half_distance * std::pow(2.0, halvings);
+            percentile += 100.0 / ticks;
+        }
+    }
+
+    out << std::setprecision(3)
+        << "#[Mean    = " << std::setw(12) << Mean() / 1000.0
+        << ", StdDeviation   = " << std::setw(12) << StdDev() / 1000.0 << "]\n"
+        << "#[Max     = " << std::setw(12) << Max() / 1000.0
+        << ", Total count    = " << std::setw(12) << total_count_ << "]\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
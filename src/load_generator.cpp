@@ -0,0 +1,416 @@
+#include "load_generator.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+uint64_t ToMicros(LoadGenerator::Clock::duration duration) {
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    return micros > 0 ? static_cast<uint64_t>(micros) : 0;
+}
+
+std::string UrlEncode(const std::string& value) {
+    static const char kHex[] = "0123456789ABCDEF";
+    std::string result;
+    result.reserve(value.size() * 3);
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            result += static_cast<char>(c);
+        }
+        else if (c == ' ') {
+            result += '+';
+        }
+        else {
+            result += '%';
+            result += kHex[c >> 4];
+            result += kHex[c & 0x0F];
+        }
+    }
+    return result;
+}
+
+void PrintLatencyRow(std::ostream& out, const char* name, const LatencyHistogram& histogram) {
+    static const double kPercentiles[] = { 50.0, 75.0, 90.0, 99.0, 99.9, 99.99 };
+    out << std::left << std::setw(14) << name << std::right;
+    for (double percentile : kPercentiles) {
+        out << std::setw(10) << histogram.ValueAtPercentile(percentile) / 1000.0;
+    }
+    out << std::setw(10) << histogram.Max() / 1000.0 << "\n";
+}
+
+} // namespace
+
+bool QuerySource::ReadLines(const std::string& filename, std::vector<std::string>& lines) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open file: " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t") + 1);
+        if (line.empty() || line[0] == '#') continue;
+        lines.push_back(std::move(line));
+    }
+    return !lines.empty();
+}
+
+bool QuerySource::LoadQueryLog(const std::string& filename) {
+    replay_ = true;
+    queries_.clear();
+    return ReadLines(filename, queries_);
+}
+
+bool QuerySource::LoadVocabulary(const std::string& filename, double exponent, int min_words, int max_words) {
+    replay_ = false;
+    vocabulary_.clear();
+    if (!ReadLines(filename, vocabulary_)) {
+        return false;
+    }
+
+    // В строке словаря может стоять частота после слова: берем только само слово
+    for (auto& word : vocabulary_) {
+        word.erase(std::min(word.find_first_of(" \t"), word.size()));
+    }
+
+    cumulative_.resize(vocabulary_.size());
+    double sum = 0.0;
+    for (size_t rank = 0; rank < vocabulary_.size(); ++rank) {
+        sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+        cumulative_[rank] = sum;
+    }
+    for (auto& value : cumulative_) {
+        value /= sum;
+    }
+
+    min_words_ = std::max(min_words, 1);
+    max_words_ = std::max(max_words, min_words_);
+    return true;
+}
+
+std::string QuerySource::Next(std::mt19937_64& rng) {
+    if (replay_) {
+        return queries_[next_query_.fetch_add(1, std::memory_order_relaxed) % queries_.size()];
+    }
+
+    std::uniform_int_distribution<int> word_count(min_words_, max_words_);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    std::string query;
+    for (int i = word_count(rng); i > 0; --i) {
+        auto it = std::lower_bound(cumulative_.begin(), cumulative_.end(), uniform(rng));
+        const size_t rank = std::min(static_cast<size_t>(it - cumulative_.begin()), vocabulary_.size() - 1);
+        if (!query.empty()) query += ' ';
+        query += vocabulary_[rank];
+    }
+    return query;
+}
+
+void BenchStats::Merge(const BenchStats& other) {
+    latency.Merge(other.latency);
+    service_time.Merge(other.service_time);
+    requests += other.requests;
+    status_2xx += other.status_2xx;
+    status_3xx += other.status_3xx;
+    status_4xx += other.status_4xx;
+    status_5xx += other.status_5xx;
+    errors += other.errors;
+    timeouts += other.timeouts;
+    connects += other.connects;
+    bytes += other.bytes;
+}
+
+LoadGenerator::LoadGenerator(const BenchOptions& options, QuerySource& queries)
+    : options_(options), queries_(queries) {
+}
+
+bool LoadGenerator::Resolve(std::string& error) {
+    try {
+        net::io_context ioc;
+        tcp::resolver resolver(ioc);
+        endpoints_ = resolver.resolve(options_.host, options_.port);
+    }
+    catch (const std::exception& e) {
+        error = "Cannot resolve " + options_.host + ": " + e.what();
+        return false;
+    }
+
+    for (const auto& entry : endpoints_) {
+        if (!entry.endpoint().address().is_loopback()) {
+            error = options_.host + " resolves to " + entry.endpoint().address().to_string() +
+                ", which is not a loopback address";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LoadGenerator::AcquireRequest(Clock::time_point when) {
+    if (options_.max_requests > 0) {
+        return issued_.fetch_add(1, std::memory_order_relaxed) < options_.max_requests;
+    }
+    return when < stop_;
+}
+
+std::string LoadGenerator::BuildTarget(Worker& worker) {
+    std::string target = options_.target;
+    target += target.find('?') == std::string::npos ? '?' : '&';
+    target += "q=";
+    target += UrlEncode(queries_.Next(worker.rng));
+    if (!options_.extra_params.empty()) {
+        target += '&';
+        target += options_.extra_params;
+    }
+    return target;
+}
+
+void LoadGenerator::Run() {
+    const int connections = std::max(options_.connections, 1);
+    int threads = options_.threads;
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+    threads = std::min(threads, connections);
+
+    workers_.clear();
+    for (int i = 0; i < threads; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->rng.seed(options_.seed + i);
+        workers_.push_back(std::move(worker));
+    }
+
+    // Небольшой запас, чтобы все потоки успели стартовать до первого запроса
+    start_ = Clock::now() + std::chrono::milliseconds(100);
+    measure_start_ = start_ + std::chrono::seconds(std::max(options_.warmup_sec, 0));
+    stop_ = measure_start_ + std::chrono::seconds(std::max(options_.duration_sec, 1));
+
+    // В открытом цикле соединение шлет запрос раз в connections / rate секунд,
+    // а начала расписаний сдвинуты, чтобы запросы шли равномерно, а не пачками
+    Clock::duration stagger{};
+    if (options_.rate > 0) {
+        interval_ = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(connections / options_.rate));
+        stagger = interval_ / connections;
+    }
+
+    for (int i = 0; i < connections; ++i) {
+        auto& worker = *workers_[i % threads];
+        auto connection = std::make_shared<BenchConnection>(*this, worker, start_ + stagger * i);
+        worker.connections.push_back(connection);
+        net::post(worker.ioc, [connection]() { connection->Start(); });
+    }
+
+    std::vector<std::thread> pool;
+    for (auto& worker : workers_) {
+        pool.emplace_back([&worker]() { worker->ioc.run(); });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    total_ = BenchStats();
+    Clock::time_point last_response = measure_start_;
+    for (auto& worker : workers_) {
+        total_.Merge(worker->stats);
+        last_response = std::max(last_response, worker->last_response);
+        worker->connections.clear();
+    }
+    measured_seconds_ = std::chrono::duration<double>(last_response - measure_start_).count();
+}
+
+void LoadGenerator::PrintReport(std::ostream& out) const {
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    out << "Target:       http://" << options_.host << ":" << options_.port << options_.target << "\n";
+    out << "Queries:      ";
+    if (queries_.IsReplay()) {
+        out << "replay of " << options_.query_log;
+    }
+    else {
+        out << "zipf(s=" << options_.zipf_exponent << ") over " << options_.vocabulary;
+    }
+    out << " (" << queries_.Size() << " entries)\n";
+    out << "Mode:         ";
+    if (options_.rate > 0) {
+        out << "open loop, " << options_.rate << " req/s";
+    }
+    else {
+        out << "closed loop";
+    }
+    out << ", " << options_.connections << " connections, keep-alive "
+        << (options_.keep_alive ? "on" : "off") << "\n\n";
+
+    const double seconds = measured_seconds_ > 0 ? measured_seconds_ : 1.0;
+    out << "Requests:     " << total_.requests << " in " << measured_seconds_ << " s\n";
+    out << "Throughput:   " << total_.requests / seconds << " req/s, "
+        << total_.bytes / seconds / (1024.0 * 1024.0) << " MiB/s\n";
+    out << "Status:       2xx=" << total_.status_2xx << " 3xx=" << total_.status_3xx
+        << " 4xx=" << total_.status_4xx << " 5xx=" << total_.status_5xx << "\n";
+    out << "Errors:       " << total_.errors << " (timeouts " << total_.timeouts << ")"
+        << ", connects " << total_.connects << "\n\n";
+
+    out << std::left << std::setw(14) << "Latency(ms)" << std::right
+        << std::setw(10) << "p50" << std::setw(10) << "p75" << std::setw(10) << "p90"
+        << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "p99.99"
+        << std::setw(10) << "max" << "\n";
+    PrintLatencyRow(out, "response", total_.latency);
+    PrintLatencyRow(out, "service", total_.service_time);
+
+    out << "\nResponse latency distribution:\n";
+    total_.latency.PrintPercentileDistribution(out);
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+BenchConnection::BenchConnection(LoadGenerator& generator, LoadGenerator::Worker& worker,
+    LoadGenerator::Clock::time_point first_send)
+    : generator_(generator),
+      worker_(worker),
+      stream_(worker.ioc),
+      timer_(worker.ioc),
+      intended_(first_send) {
+}
+
+void BenchConnection::Start() {
+    ScheduleNext();
+}
+
+void BenchConnection::ScheduleNext() {
+    const bool open_loop = generator_.options_.rate > 0;
+    if (!open_loop) {
+        intended_ = std::max(intended_, LoadGenerator::Clock::now());
+    }
+    if (!generator_.AcquireRequest(intended_)) {
+        Close();
+        return;
+    }
+
+    // Если соединение не успевает за расписанием, запрос уходит сразу,
+    // но задержка все равно считается от запланированного момента
+    timer_.expires_at(intended_);
+    timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+        if (!ec) {
+            self->Send();
+        }
+    });
+}
+
+void BenchConnection::Send() {
+    sent_ = LoadGenerator::Clock::now();
+    if (connected_) {
+        Write();
+        return;
+    }
+
+    stream_.expires_after(std::chrono::milliseconds(generator_.options_.timeout_ms));
+    stream_.async_connect(generator_.endpoints_,
+        [self = shared_from_this()](beast::error_code ec, const tcp::endpoint&) {
+            self->OnConnect(ec);
+        });
+}
+
+void BenchConnection::OnConnect(beast::error_code ec) {
+    if (ec) {
+        Fail(ec);
+        return;
+    }
+    connected_ = true;
+    ++worker_.stats.connects;
+    stream_.socket().set_option(tcp::no_delay(true), ec);
+    Write();
+}
+
+void BenchConnection::Write() {
+    const auto& options = generator_.options_;
+    request_ = {};
+    request_.method(http::verb::get);
+    request_.target(generator_.BuildTarget(worker_));
+    request_.version(11);
+    request_.set(http::field::host, options.host);
+    request_.set(http::field::user_agent, "search_bench/1.0");
+    request_.keep_alive(options.keep_alive);
+
+    stream_.expires_after(std::chrono::milliseconds(options.timeout_ms));
+    http::async_write(stream_, request_,
+        beast::bind_front_handler(&BenchConnection::OnWrite, shared_from_this()));
+}
+
+void BenchConnection::OnWrite(beast::error_code ec, std::size_t) {
+    if (ec) {
+        Fail(ec);
+        return;
+    }
+    response_ = {};
+    http::async_read(stream_, buffer_, response_,
+        beast::bind_front_handler(&BenchConnection::OnRead, shared_from_this()));
+}
+
+void BenchConnection::OnRead(beast::error_code ec, std::size_t bytes_transferred) {
+    if (ec) {
+        Fail(ec);
+        return;
+    }
+
+    const auto now = LoadGenerator::Clock::now();
+    if (generator_.Measuring(intended_)) {
+        auto& stats = worker_.stats;
+        ++stats.requests;
+        stats.bytes += bytes_transferred;
+        const unsigned status = response_.result_int();
+        if (status >= 500) ++stats.status_5xx;
+        else if (status >= 400) ++stats.status_4xx;
+        else if (status >= 300) ++stats.status_3xx;
+        else ++stats.status_2xx;
+        stats.latency.Record(ToMicros(now - intended_));
+        stats.service_time.Record(ToMicros(now - sent_));
+        worker_.last_response = std::max(worker_.last_response, now);
+    }
+
+    if (!response_.keep_alive()) {
+        Close();
+    }
+    intended_ += generator_.interval_;
+    ScheduleNext();
+}
+
+void BenchConnection::Fail(beast::error_code ec) {
+    if (generator_.Measuring(intended_)) {
+        ++worker_.stats.errors;
+        if (ec == beast::error::timeout) {
+            ++worker_.stats.timeouts;
+        }
+    }
+    Close();
+    buffer_.clear();
+
+    // В закрытом цикле без паузы соединение крутилось бы на отказах сервера
+    if (generator_.options_.rate > 0) {
+        intended_ += generator_.interval_;
+    }
+    else {
+        intended_ = LoadGenerator::Clock::now() + std::chrono::milliseconds(10);
+    }
+    ScheduleNext();
+}
+
+void BenchConnection::Close() {
+    if (connected_) {
+        beast::error_code ec;
+        stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+        connected_ = false;
+    }
+    stream_.close();
+}
@@ -0,0 +1,328 @@
+#include "load_generator.h"
+#include "server_process.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Сценарий масштабирования: сервер перезапускается с разным числом потоков
+struct ScaleOptions {
+    int max_threads = 0;            // 0 - сценарий выключен
+#ifdef _WIN32
+    std::string server = "search_server.exe";
+#else
+    std::string server = "./search_server";
+#endif
+    std::string server_config = "config.ini";
+    std::string work_dir = "bench_scale";
+};
+
+void PrintUsage() {
+    std::cout <<
+        "Usage: search_bench (--queries=FILE | --vocabulary=FILE) [options]\n"
+        "\n"
+        "  --queries=FILE        replay queries from FILE, one per line, in order\n"
+        "  --vocabulary=FILE     draw words from FILE (most frequent first) by Zipf's law\n"
+        "  --zipf=S              Zipf exponent (default 1.0)\n"
+        "  --words=MIN-MAX       words per generated query (default 1-2)\n"
+        "  --host=HOST           server host, must be loopback (default 127.0.0.1)\n"
+        "  --port=PORT           server port (default 8080)\n"
+        "  --path=PATH           request path (default /api/search)\n"
+        "  --params=STRING       extra query string, e.g. limit=10&offset=0\n"
+        "  --connections=N       concurrent connections (default 16); all of them come from\n"
+        "                        one loopback address, so against a running server keep N\n"
+        "                        within its max_connections_per_ip (32 in config.ini) or\n"
+        "                        the refused connections are counted as errors\n"
+        "  --threads=N           client threads (default: number of cores)\n"
+        "  --rate=R              open loop at R requests/s in total; 0 = closed loop (default 0)\n"
+        "  --duration=SEC        measured duration (default 10)\n"
+        "  --warmup=SEC          warmup not included in results (default 1)\n"
+        "  --requests=N          stop after N requests instead of by time\n"
+        "  --keep-alive=on|off   reuse connections (default on)\n"
+        "  --timeout=MS          per-request timeout (default 5000)\n"
+        "  --seed=N              random seed (default 1)\n"
+        "  --compare-keep-alive  run twice against the same server, with keep-alive on\n"
+        "                        and off, and print requests/s and p99 side by side\n"
+        "\n"
+        "Scaling (starts its own search_server):\n"
+        "  --scale=N             run against search_server with reuse_port=true and\n"
+        "                        1, 2, 4, ... N threads; report requests/s per step\n"
+        "  --server=PATH         search_server executable (default ./search_server)\n"
+        "  --server-config=FILE  config for it; threads, reuse_port, port and\n"
+        "                        max_connections_per_ip are replaced (default config.ini)\n"
+        "  --scale-dir=DIR       working directory of the started server (default bench_scale)\n";
+}
+
+bool ParseOption(const std::string& key, const std::string& value, BenchOptions& options) {
+    if (key == "queries") options.query_log = value;
+    else if (key == "vocabulary") options.vocabulary = value;
+    else if (key == "zipf") options.zipf_exponent = std::stod(value);
+    else if (key == "words") {
+        size_t dash = value.find('-');
+        options.min_words = std::stoi(value.substr(0, dash));
+        options.max_words = dash == std::string::npos ? options.min_words : std::stoi(value.substr(dash + 1));
+    }
+    else if (key == "host") options.host = value;
+    else if (key == "port") options.port = value;
+    else if (key == "path") options.target = value;
+    else if (key == "params") options.extra_params = value;
+    else if (key == "connections") options.connections = std::stoi(value);
+    else if (key == "threads") options.threads = std::stoi(value);
+    else if (key == "rate") options.rate = std::stod(value);
+    else if (key == "duration") options.duration_sec = std::stoi(value);
+    else if (key == "warmup") options.warmup_sec = std::stoi(value);
+    else if (key == "requests") options.max_requests = std::stoull(value);
+    else if (key == "keep-alive") options.keep_alive = value == "on" || value == "true" || value == "1";
+    else if (key == "timeout") options.timeout_ms = std::stoi(value);
+    else if (key == "seed") options.seed = std::stoull(value);
+    else return false;
+    return true;
+}
+
+bool ParseScaleOption(const std::string& key, const std::string& value, ScaleOptions& scale) {
+    if (key == "scale") scale.max_threads = std::stoi(value);
+    else if (key == "server") scale.server = value;
+    else if (key == "server-config") scale.server_config = value;
+    else if (key == "scale-dir") scale.work_dir = value;
+    else return false;
+    return true;
+}
+
+// Ждет, пока сервер начнет принимать соединения; false, если он завершился или не успел
+bool WaitForServer(const BenchOptions& options, ServerProcess& server, int timeout_sec) {
+    net::io_context ioc;
+    tcp::resolver resolver(ioc);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_sec);
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (!server.Running()) {
+            return false;
+        }
+        beast::error_code ec;
+        auto endpoints = resolver.resolve(options.host, options.port, ec);
+        if (!ec) {
+            tcp::socket socket(ioc);
+            net::connect(socket, endpoints, ec);
+            if (!ec) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+// Один прогон с keep-alive и один без него против одного и того же сервера.
+// Без keep-alive каждый запрос платит за новое TCP-соединение (и слот
+// max_connections_per_ip на сервере), разница и показывает цену установки соединения.
+int RunKeepAliveComparison(const BenchOptions& options, QuerySource& queries) {
+    struct Run {
+        const char* name;
+        double requests_per_sec;
+        double p99_ms;
+        uint64_t errors;
+    };
+
+    std::vector<Run> runs;
+    for (bool keep_alive : { true, false }) {
+        BenchOptions run_options = options;
+        run_options.keep_alive = keep_alive;
+
+        std::cout << "--- keep-alive " << (keep_alive ? "on" : "off") << " ---" << std::endl;
+        LoadGenerator generator(run_options, queries);
+        std::string error;
+        if (!generator.Resolve(error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        generator.Run();
+        generator.PrintReport(std::cout);
+
+        const BenchStats& stats = generator.Stats();
+        const double seconds = generator.MeasuredSeconds() > 0 ? generator.MeasuredSeconds() : 1.0;
+        runs.push_back({ keep_alive ? "on" : "off", stats.requests / seconds,
+            stats.latency.ValueAtPercentile(99.0) / 1000.0, stats.errors });
+    }
+
+    std::cout << "\n=== Keep-alive comparison ===" << std::endl;
+    std::cout << std::left << std::setw(12) << "Keep-alive" << std::right << std::setw(14) << "Requests/s"
+        << std::setw(12) << "p99(ms)" << std::setw(10) << "Errors" << std::endl;
+    std::cout << std::fixed;
+    for (const auto& run : runs) {
+        std::cout << std::left << std::setw(12) << run.name << std::right
+            << std::setw(14) << std::setprecision(1) << run.requests_per_sec
+            << std::setw(12) << std::setprecision(3) << run.p99_ms
+            << std::setw(10) << run.errors << std::endl;
+    }
+    if (runs[1].requests_per_sec > 0) {
+        std::cout << "Keep-alive speedup: " << std::setprecision(2)
+            << runs[0].requests_per_sec / runs[1].requests_per_sec << "x" << std::endl;
+    }
+    return runs[0].requests_per_sec > 0 && runs[1].requests_per_sec > 0 ? 0 : 1;
+}
+
+// Прогон на каждом шаге числа потоков сервера и сводная таблица.
+// Генератор нагрузки работает на той же машине: его --threads лучше
+// ограничить, чтобы он не отнимал ядра у сервера на старших шагах.
+int RunScaling(const BenchOptions& options, QuerySource& queries, const ScaleOptions& scale) {
+    struct Step {
+        int threads;
+        double requests_per_sec;
+        double p99_ms;
+        uint64_t errors;
+    };
+
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < scale.max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(scale.max_threads);
+
+    // Все соединения бенчмарка идут с одного адреса: предел на IP из конфигурации
+    // отказывал бы в лишних, и отказы считались бы ошибками. Запас вдвое - на
+    // слоты, которые сервер еще не освободил после закрытия соединения клиентом
+    const std::string per_ip_limit = std::to_string(std::max(options.connections, 1) * 2);
+
+    std::vector<Step> steps;
+    for (int threads : thread_counts) {
+        std::string error;
+        if (!ServerProcess::WriteConfig(scale.server_config, scale.work_dir, "search_server",
+            { { "threads", std::to_string(threads) }, { "reuse_port", "true" }, { "port", options.port },
+              { "max_connections_per_ip", per_ip_limit } }, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+
+        ServerProcess server;
+        if (!server.Start(scale.server, scale.work_dir, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        if (!WaitForServer(options, server, 30)) {
+            std::cerr << "search_server with " << threads << " threads did not start, see "
+                << scale.work_dir << "/server.log" << std::endl;
+            return 1;
+        }
+
+        std::cout << "--- search_server: " << threads << " threads, reuse_port=true ---" << std::endl;
+        LoadGenerator generator(options, queries);
+        if (!generator.Resolve(error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        generator.Run();
+        generator.PrintReport(std::cout);
+        server.Stop();
+
+        const BenchStats& stats = generator.Stats();
+        const double seconds = generator.MeasuredSeconds() > 0 ? generator.MeasuredSeconds() : 1.0;
+        steps.push_back({ threads, stats.requests / seconds,
+            stats.latency.ValueAtPercentile(99.0) / 1000.0, stats.errors });
+    }
+
+    std::cout << "\n=== Scaling (reuse_port=true) ===" << std::endl;
+    std::cout << std::left << std::setw(10) << "Threads" << std::right << std::setw(14) << "Requests/s"
+        << std::setw(10) << "Speedup" << std::setw(12) << "p99(ms)" << std::setw(10) << "Errors" << std::endl;
+    std::cout << std::fixed;
+    for (const auto& step : steps) {
+        const double base = steps.front().requests_per_sec;
+        std::cout << std::left << std::setw(10) << step.threads << std::right
+            << std::setw(14) << std::setprecision(1) << step.requests_per_sec
+            << std::setw(9) << std::setprecision(2) << (base > 0 ? step.requests_per_sec / base : 0.0) << "x"
+            << std::setw(12) << std::setprecision(3) << step.p99_ms
+            << std::setw(10) << step.errors << std::endl;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    ScaleOptions scale;
+    bool compare_keep_alive = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return 0;
+        }
+        if (arg == "--compare-keep-alive") {
+            compare_keep_alive = true;
+            continue;
+        }
+
+        size_t eq_pos = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq_pos == std::string::npos) {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            PrintUsage();
+            return 1;
+        }
+
+        try {
+            const std::string key = arg.substr(2, eq_pos - 2);
+            const std::string value = arg.substr(eq_pos + 1);
+            if (!ParseOption(key, value, options) && !ParseScaleOption(key, value, scale)) {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        }
+        catch (const std::exception&) {
+            std::cerr << "Invalid value: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // Источник запросов
+    QuerySource queries;
+    if (!options.query_log.empty()) {
+        if (!queries.LoadQueryLog(options.query_log)) {
+            std::cerr << "No queries in " << options.query_log << std::endl;
+            return 1;
+        }
+    }
+    else if (!options.vocabulary.empty()) {
+        if (!queries.LoadVocabulary(options.vocabulary, options.zipf_exponent,
+            options.min_words, options.max_words)) {
+            std::cerr << "No words in " << options.vocabulary << std::endl;
+            return 1;
+        }
+    }
+    else {
+        std::cerr << "Either --queries or --vocabulary is required" << std::endl;
+        PrintUsage();
+        return 1;
+    }
+
+    if (scale.max_threads > 0) {
+        return RunScaling(options, queries, scale);
+    }
+    if (compare_keep_alive) {
+        return RunKeepAliveComparison(options, queries);
+    }
+
+    LoadGenerator generator(options, queries);
+    std::string error;
+    if (!generator.Resolve(error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "=== Search Engine Benchmark ===" << std::endl;
+    std::cout << "Running for " << options.warmup_sec << " s warmup + ";
+    if (options.max_requests > 0) {
+        std::cout << options.max_requests << " requests" << std::endl;
+    }
+    else {
+        std::cout << options.duration_sec << " s" << std::endl;
+    }
+
+    generator.Run();
+    generator.PrintReport(std::cout);
+
+    return generator.Stats().requests > 0 ? 0 : 1;
+}
@@ -8,14 +8,14 @@
 int main() {
     std::cout << "=== Search Engine Server ===" << std::endl;
 
-    //  
+    // Загрузка конфигурации
     Config config;
     if (!config.Load("config.ini")) {
         std::cerr << "Failed to load config file" << std::endl;
         return 1;
     }
 
-    //    
+    // Подключение к базе данных
     Database db;
     if (!db.Connect(config.GetDatabaseHost(), config.GetDatabasePort(),
         config.GetDatabaseName(), config.GetDatabaseUser(),
@@ -25,17 +25,20 @@ int main() {
     }
 
     std::cout << "Database connection established." << std::endl;
+
+    // Отдельные соединения для поиска, чтобы запросы не ждали друг друга
+    db.OpenReadPool(config.GetDatabaseReadPoolSize());
     std::cout << "Starting HTTP server on " << config.GetServerHost()
         << ":" << config.GetServerPort() << std::endl;
 
     try {
-        //  HTTP 
+        // Запуск HTTP сервера
         BeastHttpServer server(config, db);
         server.Start();
 
         std::cout << "Server is running. Press Ctrl+C to stop." << std::endl;
 
-        //      
+        // Бесконечный цикл для поддержания работы сервера
         while (true) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
@@ -0,0 +1,437 @@
+#include "http_client.h"
+#include "seen_set.h"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Поток вывода в никуда: HttpClient пишет строку на каждую загрузку
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// Подавляет std::cout на время замера
+class QuietScope {
+public:
+    QuietScope() : saved_(std::cout.rdbuf(&null_)) {}
+    ~QuietScope() { std::cout.rdbuf(saved_); }
+
+private:
+    NullBuffer null_;
+    std::streambuf* saved_;
+};
+
+// Локальный тестовый сервер, который отвечает с задержкой, как медленный сайт.
+// Задержка выдерживается таймером, поэтому сервер держит любое число соединений.
+class SlowServer {
+public:
+    SlowServer(int delay_ms, size_t body_size)
+        : delay_(std::chrono::milliseconds(delay_ms)),
+          body_("<html><head><title>bench</title></head><body>" + std::string(body_size, 'x') + "</body></html>") {
+        tcp::endpoint endpoint(net::ip::make_address("127.0.0.1"), 0);
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+        acceptor_.bind(endpoint);
+        acceptor_.listen(net::socket_base::max_listen_connections);
+        Accept();
+        for (int i = 0; i < 2; ++i) {
+            threads_.emplace_back([this]() { ioc_.run(); });
+        }
+    }
+
+    ~SlowServer() {
+        ioc_.stop();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    unsigned short Port() const { return acceptor_.local_endpoint().port(); }
+    uint64_t Connections() const { return connections_; }
+
+private:
+    struct Session : std::enable_shared_from_this<Session> {
+        Session(tcp::socket&& socket, SlowServer& server)
+            : stream(std::move(socket)), timer(stream.get_executor()), server(server) {}
+
+        void Read() {
+            request = {};
+            http::async_read(stream, buffer, request,
+                [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                    if (ec) return;
+                    self->timer.expires_after(self->server.delay_);
+                    self->timer.async_wait([self](beast::error_code ec) {
+                        if (!ec) self->Write();
+                    });
+                });
+        }
+
+        void Write() {
+            response = { http::status::ok, request.version() };
+            response.set(http::field::content_type, "text/html; charset=utf-8");
+            response.keep_alive(request.keep_alive());
+            response.body() = server.body_;
+            response.prepare_payload();
+            http::async_write(stream, response,
+                [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                    if (ec) return;
+                    if (self->response.keep_alive()) {
+                        self->Read();
+                    }
+                    else {
+                        self->stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+                    }
+                });
+        }
+
+        beast::tcp_stream stream;
+        net::steady_timer timer;
+        SlowServer& server;
+        beast::flat_buffer buffer;
+        http::request<http::empty_body> request;
+        http::response<http::string_body> response;
+    };
+
+    void Accept() {
+        acceptor_.async_accept(net::make_strand(ioc_), [this](beast::error_code ec, tcp::socket socket) {
+            if (!ec) {
+                ++connections_;
+                std::make_shared<Session>(std::move(socket), *this)->Read();
+            }
+            Accept();
+        });
+    }
+
+    net::io_context ioc_;
+    tcp::acceptor acceptor_{ ioc_ };
+    std::vector<std::thread> threads_;
+    Clock::duration delay_;
+    std::string body_;
+    std::atomic<uint64_t> connections_{ 0 };
+};
+
+struct FetchResult {
+    int pages = 0;
+    int failed = 0;
+    double seconds = 0.0;
+    HttpClient::PoolStats pool;
+    DnsCache::Stats dns;
+};
+
+void AddPoolStats(HttpClient::PoolStats& total, const HttpClient::PoolStats& stats) {
+    total.hits += stats.hits;
+    total.misses += stats.misses;
+    total.setup_seconds += stats.setup_seconds;
+    total.saved_seconds += stats.saved_seconds;
+}
+
+// Синхронная загрузка: по одной странице за раз в каждом потоке, как раньше делал паук
+FetchResult RunBlocking(const std::string& url, int pages, int threads) {
+    FetchResult result;
+    std::atomic<int> next{ 0 };
+    std::atomic<int> failed{ 0 };
+    std::mutex stats_mutex;
+
+    auto start = Clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; ++i) {
+        pool.emplace_back([&]() {
+            HttpClient client;
+            while (next++ < pages) {
+                if (client.DownloadPage(url).status_code != 200) {
+                    ++failed;
+                }
+            }
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            AddPoolStats(result.pool, client.GetPoolStats());
+            auto dns = client.GetContext().GetDnsCache().GetStats();
+            result.dns.hits += dns.hits;
+            result.dns.misses += dns.misses;
+            result.dns.coalesced += dns.coalesced;
+        });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.pages = pages;
+    result.failed = failed;
+    return result;
+}
+
+// Асинхронная загрузка: один поток ввода-вывода, до concurrency загрузок одновременно
+FetchResult RunAsync(const std::string& url, int pages, int concurrency) {
+    FetchResult result;
+    HttpClient client;
+    int started = 0;
+
+    std::function<void()> start_next = [&]() {
+        if (started >= pages) return;
+        ++started;
+        client.AsyncDownload(url, [&](HttpClient::HttpResponse response) {
+            ++result.pages;
+            if (response.status_code != 200) {
+                ++result.failed;
+            }
+            start_next();
+        });
+    };
+
+    auto start = Clock::now();
+    for (int i = 0; i < concurrency; ++i) {
+        start_next();
+    }
+    client.GetIoContext().run();
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.pool = client.GetPoolStats();
+    result.dns = client.GetContext().GetDnsCache().GetStats();
+    return result;
+}
+
+void PrintResult(const char* name, const FetchResult& result) {
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(8) << result.pages << " pages" << std::setw(10) << result.seconds << " s"
+        << std::setw(12) << result.pages / std::max(result.seconds, 1e-9) << " pages/s"
+        << "  failed " << result.failed << "\n";
+    std::cout << std::setw(28) << "" << "  keep-alive reuse " << std::setprecision(1)
+        << result.pool.HitRate() * 100 << "% (" << result.pool.hits << " reused, " << result.pool.misses
+        << " new), setup " << std::setprecision(3) << result.pool.setup_seconds << " s, saved ~"
+        << result.pool.saved_seconds << " s\n";
+    std::cout << std::setw(28) << "" << "  dns " << result.dns.misses << " resolved, "
+        << result.dns.hits << " cached, " << result.dns.coalesced << " coalesced\n";
+}
+
+int RunFetchBench(const std::map<std::string, std::string>& args) {
+    auto get = [&args](const std::string& key, int fallback) {
+        auto it = args.find(key);
+        return it == args.end() ? fallback : std::stoi(it->second);
+    };
+    const int pages = get("pages", 2000);
+    const int delay_ms = get("delay-ms", 100);
+    const int body_size = get("size", 16384);
+    const int concurrency = get("concurrency", 256);
+    const int threads = get("threads", 4);
+
+    SlowServer server(delay_ms, static_cast<size_t>(body_size));
+    const std::string url = "http://127.0.0.1:" + std::to_string(server.Port()) + "/page";
+
+    std::cout << "Slow server on " << url << ": " << delay_ms << " ms per response, "
+        << body_size << " bytes body" << std::endl;
+
+    FetchResult blocking;
+    FetchResult async;
+    {
+        QuietScope quiet;
+        // Синхронному варианту хватает меньшей выборки, он на порядки медленнее
+        blocking = RunBlocking(url, std::min(pages, threads * 20), threads);
+        async = RunAsync(url, pages, concurrency);
+    }
+
+    PrintResult(("blocking, " + std::to_string(threads) + " threads").c_str(), blocking);
+    PrintResult(("async, " + std::to_string(concurrency) + " in flight").c_str(), async);
+    std::cout << "Server accepted " << server.Connections() << " connections" << std::endl;
+    return async.failed == 0 ? 0 : 1;
+}
+
+// Аллокатор, считающий выделенную память: так измеряется std::unordered_set
+// со строками, включая узлы, корзины и сами строки
+std::atomic<int64_t> g_counted_bytes{ 0 };
+
+template <class T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <class U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        g_counted_bytes += static_cast<int64_t>(n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) {
+        g_counted_bytes -= static_cast<int64_t>(n * sizeof(T));
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <class U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+using CountedString = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+
+struct CountedStringHash {
+    size_t operator()(const CountedString& s) const {
+        return std::hash<std::string_view>()(std::string_view(s.data(), s.size()));
+    }
+};
+
+// Прежняя схема: строки в std::unordered_set под одним мьютексом
+class MutexStringSet {
+public:
+    bool Insert(const std::string& url) {
+        CountedString key(url.data(), url.size());
+        std::lock_guard<std::mutex> lock(mutex_);
+        return set_.insert(std::move(key)).second;
+    }
+
+private:
+    std::mutex mutex_;
+    std::unordered_set<CountedString, CountedStringHash, std::equal_to<CountedString>,
+        CountingAllocator<CountedString>> set_;
+};
+
+struct SeenResult {
+    double insert_seconds = 0;
+    double duplicate_seconds = 0;
+    size_t inserted = 0;
+    size_t memory_bytes = 0;
+};
+
+// Вставляет все URL, поделив их между потоками; возвращает секунды и число новых
+template <class InsertFn>
+double RunInserts(const std::vector<std::string>& urls, int threads, InsertFn insert, size_t& inserted) {
+    std::atomic<size_t> total{ 0 };
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            size_t local = 0;
+            for (size_t i = t; i < urls.size(); i += threads) {
+                local += insert(urls[i]) ? 1 : 0;
+            }
+            total += local;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    inserted = total;
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <class Set>
+SeenResult MeasureSeenSet(Set& set, const std::vector<std::string>& urls, int threads) {
+    SeenResult result;
+    auto insert = [&set](const std::string& url) { return set.Insert(url); };
+    result.insert_seconds = RunInserts(urls, threads, insert, result.inserted);
+    size_t duplicates_inserted = 0;
+    result.duplicate_seconds = RunInserts(urls, threads, insert, duplicates_inserted);
+    if (duplicates_inserted != 0) {
+        std::cerr << "Duplicate URLs were inserted again: " << duplicates_inserted << std::endl;
+    }
+    return result;
+}
+
+void PrintSeenResult(const char* name, const SeenResult& result, size_t urls) {
+    std::cout << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(1)
+        << std::setw(8) << static_cast<double>(result.memory_bytes) / urls << " B/URL"
+        << std::setprecision(2)
+        << std::setw(10) << urls / result.insert_seconds / 1e6 << " M new/s"
+        << std::setw(10) << urls / result.duplicate_seconds / 1e6 << " M dup/s"
+        << "  stored " << result.inserted << "\n";
+}
+
+int RunSeenBench(const std::map<std::string, std::string>& args) {
+    auto get = [&args](const std::string& key, int fallback) {
+        auto it = args.find(key);
+        return it == args.end() ? fallback : std::stoi(it->second);
+    };
+    const size_t count = static_cast<size_t>(get("urls", 2000000));
+    const int threads = std::max(get("threads", 4), 1);
+    const size_t expected = static_cast<size_t>(get("expected", static_cast<int>(count)));
+
+    std::vector<std::string> urls;
+    urls.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        urls.push_back("https://host" + std::to_string(i % 50000) + ".example.com/section/" +
+            std::to_string(i % 1000) + "/page-" + std::to_string(i) + ".html");
+    }
+    std::cout << count << " URLs, " << threads << " threads, seen-set sized for " << expected << std::endl;
+
+    SeenResult baseline;
+    {
+        MutexStringSet set;
+        int64_t before = g_counted_bytes;
+        baseline = MeasureSeenSet(set, urls, threads);
+        baseline.memory_bytes = static_cast<size_t>(g_counted_bytes - before);
+    }
+    PrintSeenResult("unordered_set<string> + mutex", baseline, count);
+
+    for (bool bloom : { true, false }) {
+        SeenSet set(expected, bloom);
+        SeenResult result = MeasureSeenSet(set, urls, threads);
+        result.memory_bytes = set.MemoryBytes();
+        PrintSeenResult(bloom ? "SeenSet, Bloom front" : "SeenSet, no Bloom", result, count);
+        if (bloom) {
+            auto stats = set.GetStats();
+            std::cout << std::setw(30) << "" << "  Bloom answered \"new\" for "
+                << std::setprecision(1) << 100.0 * stats.bloom_negatives / count << "% of new URLs\n";
+        }
+    }
+    return 0;
+}
+
+void PrintUsage() {
+    std::cout <<
+        "Usage: spider_bench <mode> [--key=value ...]\n"
+        "\n"
+        "  fetch    download pages from a local slow server, blocking vs async\n"
+        "           --pages=2000 --delay-ms=100 --size=16384 --concurrency=256 --threads=4\n"
+        "  seen     memory per URL and insert rate of the visited-URL set\n"
+        "           --urls=2000000 --threads=4 --expected=<urls>\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::string mode = argv[1];
+    std::map<std::string, std::string> args;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq_pos = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq_pos == std::string::npos) {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+        args[arg.substr(2, eq_pos - 2)] = arg.substr(eq_pos + 1);
+    }
+
+    try {
+        if (mode == "fetch") {
+            return RunFetchBench(args);
+        }
+        if (mode == "seen") {
+            return RunSeenBench(args);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Benchmark error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    PrintUsage();
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "metrics.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+uint64_t DoubleToBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double BitsToDouble(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Метки с добавленной меткой le для корзины гистограммы
+std::string WithLe(const std::string& labels, const std::string& le) {
+    std::string result = "{";
+    if (!labels.empty()) {
+        result += labels;
+        result += ",";
+    }
+    result += "le=\"" + le + "\"}";
+    return result;
+}
+
+std::string Braced(const std::string& labels) {
+    return labels.empty() ? std::string() : "{" + labels + "}";
+}
+
+} // namespace
+
+Metrics::Metrics() {
+    // Запись читает metrics_ без блокировки, поэтому вектор не должен перевыделяться
+    metrics_.reserve(kMaxSlots);
+}
+
+Metrics& Metrics::Instance() {
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::Id Metrics::RegisterCounter(const std::string& name, const std::string& help, const std::string& labels) {
+    return Register(Type::Counter, name, help, labels, {});
+}
+
+Metrics::Id Metrics::RegisterGauge(const std::string& name, const std::string& help, const std::string& labels) {
+    return Register(Type::Gauge, name, help, labels, {});
+}
+
+Metrics::Id Metrics::RegisterHistogram(const std::string& name, const std::string& help,
+    const std::vector<double>& bounds, const std::string& labels) {
+    return Register(Type::Histogram, name, help, labels, bounds);
+}
+
+Metrics::Id Metrics::Register(Type type, const std::string& name, const std::string& help,
+    const std::string& labels, const std::vector<double>& bounds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (size_t i = 0; i < metrics_.size(); ++i) {
+        if (metrics_[i].name == name && metrics_[i].labels == labels) {
+            return static_cast<Id>(i);
+        }
+    }
+
+    // Гистограмма: корзины + бесконечная корзина + count + sum
+    size_t slots = type == Type::Histogram ? bounds.size() + 3 : 1;
+    if (next_slot_ + slots > kMaxSlots) {
+        throw std::length_error("Metrics registry is full");
+    }
+
+    Metric metric{ type, name, help, labels, bounds, next_slot_ };
+    next_slot_ += slots;
+    metrics_.push_back(std::move(metric));
+    return static_cast<Id>(metrics_.size() - 1);
+}
+
+Metrics::Shard& Metrics::LocalShard() {
+    thread_local Shard* shard = nullptr;
+    if (!shard) {
+        // Шард живет до конца процесса: накопленные значения завершившихся потоков не теряются
+        auto owned = std::make_unique<Shard>();
+        shard = owned.get();
+        std::lock_guard<std::mutex> lock(mutex_);
+        shards_.push_back(std::move(owned));
+    }
+    return *shard;
+}
+
+void Metrics::Increment(Id counter, uint64_t delta) {
+    // metrics_ не перевыделяется после старта, поэтому slot читается без блокировки
+    auto& slot = LocalShard().slots[metrics_[counter].slot];
+    slot.store(slot.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void Metrics::AddGauge(Id gauge, int64_t delta) {
+    gauges_[metrics_[gauge].slot].fetch_add(delta, std::memory_order_relaxed);
+}
+
+void Metrics::SetGauge(Id gauge, int64_t value) {
+    gauges_[metrics_[gauge].slot].store(value, std::memory_order_relaxed);
+}
+
+void Metrics::Observe(Id histogram, double value) {
+    const Metric& metric = metrics_[histogram];
+    Shard& shard = LocalShard();
+
+    size_t bucket = 0;
+    while (bucket < metric.bounds.size() && value > metric.bounds[bucket]) {
+        ++bucket;
+    }
+
+    size_t base = metric.slot;
+    size_t count_slot = base + metric.bounds.size() + 1;
+    size_t sum_slot = count_slot + 1;
+
+    auto& bucket_cell = shard.slots[base + bucket];
+    bucket_cell.store(bucket_cell.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    auto& count_cell = shard.slots[count_slot];
+    count_cell.store(count_cell.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    auto& sum_cell = shard.slots[sum_slot];
+    double sum = BitsToDouble(sum_cell.load(std::memory_order_relaxed)) + value;
+    sum_cell.store(DoubleToBits(sum), std::memory_order_relaxed);
+}
+
+uint64_t Metrics::SumSlot(size_t slot) const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->slots[slot].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double Metrics::SumDoubleSlot(size_t slot) const {
+    double total = 0.0;
+    for (const auto& shard : shards_) {
+        total += BitsToDouble(shard->slots[slot].load(std::memory_order_relaxed));
+    }
+    return total;
+}
+
+std::string Metrics::Render() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::ostringstream out;
+    std::unordered_set<std::string> described;
+
+    // Формат требует, чтобы все серии одного семейства шли подряд:
+    // выводим семейства в порядке регистрации, собирая серии с тем же именем
+    for (const auto& family : metrics_) {
+        if (!described.insert(family.name).second) {
+            continue;
+        }
+
+        const char* type = family.type == Type::Counter ? "counter" :
+            family.type == Type::Gauge ? "gauge" : "histogram";
+        out << "# HELP " << family.name << " " << family.help << "\n";
+        out << "# TYPE " << family.name << " " << type << "\n";
+
+        for (const auto& metric : metrics_) {
+            if (metric.name == family.name) {
+                RenderMetric(out, metric);
+            }
+        }
+    }
+
+    return out.str();
+}
+
+void Metrics::RenderMetric(std::ostream& out, const Metric& metric) const {
+    switch (metric.type) {
+    case Type::Counter:
+        out << metric.name << Braced(metric.labels) << " " << SumSlot(metric.slot) << "\n";
+        break;
+    case Type::Gauge:
+        out << metric.name << Braced(metric.labels) << " "
+            << gauges_[metric.slot].load(std::memory_order_relaxed) << "\n";
+        break;
+    case Type::Histogram: {
+        // Корзины Prometheus накопительные
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < metric.bounds.size(); ++i) {
+            cumulative += SumSlot(metric.slot + i);
+            std::ostringstream le;
+            le << metric.bounds[i];
+            out << metric.name << "_bucket" << WithLe(metric.labels, le.str()) << " " << cumulative << "\n";
+        }
+        cumulative += SumSlot(metric.slot + metric.bounds.size());
+        out << metric.name << "_bucket" << WithLe(metric.labels, "+Inf") << " " << cumulative << "\n";
+
+        size_t count_slot = metric.slot + metric.bounds.size() + 1;
+        out << metric.name << "_sum" << Braced(metric.labels) << " " << SumDoubleSlot(count_slot + 1) << "\n";
+        out << metric.name << "_count" << Braced(metric.labels) << " " << SumSlot(count_slot) << "\n";
+        break;
+    }
+    }
+}
+
+bool Metrics::DumpToFile(const std::string& filename) const {
+    // Пишем во временный файл и переименовываем, чтобы читатель не увидел половину
+    std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream file(tmp_filename, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Cannot write metrics file: " << tmp_filename << std::endl;
+            return false;
+        }
+        file << Render();
+    }
+
+    std::remove(filename.c_str());
+    if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Cannot rename metrics file: " << tmp_filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const std::vector<double>& Metrics::LatencyBuckets() {
+    static const std::vector<double> buckets = {
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+    };
+    return buckets;
+}
+
+const std::vector<double>& Metrics::SizeBuckets() {
+    static const std::vector<double> buckets = {
+        1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216
+    };
+    return buckets;
+}
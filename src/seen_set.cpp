@@ -0,0 +1,191 @@
+#include "seen_set.h"
+#include <algorithm>
+
+namespace {
+
+size_t NextPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Перемешивание splitmix64: равномерные младшие биты для индекса слота
+uint64_t Mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+// Четыре бита фильтра Блума из младших 24 бит отпечатка
+uint64_t BloomBits(uint64_t fingerprint) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 4; ++i) {
+        bits |= 1ULL << ((fingerprint >> (i * 6)) & 63);
+    }
+    return bits;
+}
+
+} // namespace
+
+SeenSet::SeenSet(size_t expected_urls, bool use_bloom, size_t shards)
+    : use_bloom_(use_bloom) {
+    shards = NextPowerOfTwo(std::max<size_t>(shards, 1));
+    shard_mask_ = shards - 1;
+
+    const size_t per_shard = std::max<size_t>(expected_urls / shards, 16);
+    const size_t capacity = NextPowerOfTwo(static_cast<size_t>(per_shard / kMaxLoad) + 1);
+    const size_t bloom_words = NextPowerOfTwo((per_shard * kBloomBitsPerUrl + 63) / 64);
+
+    for (size_t i = 0; i < shards; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->slots.assign(capacity, 0);
+        if (use_bloom_) {
+            shard->bloom.assign(bloom_words, 0);
+        }
+        shards_.push_back(std::move(shard));
+    }
+}
+
+uint64_t SeenSet::Fingerprint(const std::string& url) {
+    // FNV-1a и финальное перемешивание; 0 зарезервирован под пустой слот
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : url) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    hash = Mix(hash);
+    return hash == 0 ? 1 : hash;
+}
+
+SeenSet::Shard& SeenSet::ShardFor(uint64_t fingerprint) const {
+    // Шард по старшим битам, слот по младшим, биты фильтра по средним
+    return *shards_[(fingerprint >> 56) & shard_mask_];
+}
+
+// Возвращает true, если все биты отпечатка уже стояли (URL, возможно, видели);
+// иначе выставляет их и возвращает false
+bool SeenSet::BloomTestAndSet(Shard& shard, uint64_t fingerprint) {
+    uint64_t& word = shard.bloom[(fingerprint >> 24) & (shard.bloom.size() - 1)];
+    const uint64_t bits = BloomBits(fingerprint);
+    bool present = (word & bits) == bits;
+    word |= bits;
+    return present;
+}
+
+bool SeenSet::TableInsert(Shard& shard, uint64_t fingerprint) {
+    const size_t mask = shard.slots.size() - 1;
+    for (size_t i = fingerprint & mask;; i = (i + 1) & mask) {
+        if (shard.slots[i] == fingerprint) {
+            return false;
+        }
+        if (shard.slots[i] == 0) {
+            shard.slots[i] = fingerprint;
+            ++shard.count;
+            return true;
+        }
+    }
+}
+
+void SeenSet::Grow(Shard& shard) {
+    std::vector<uint64_t> old;
+    old.swap(shard.slots);
+    shard.slots.assign(old.size() * 2, 0);
+    shard.count = 0;
+    for (uint64_t fingerprint : old) {
+        if (fingerprint != 0) {
+            TableInsert(shard, fingerprint);
+        }
+    }
+}
+
+bool SeenSet::InsertFingerprint(uint64_t fingerprint) {
+    fingerprint = fingerprint == 0 ? 1 : fingerprint;
+    Shard& shard = ShardFor(fingerprint);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (shard.count + 1 > shard.slots.size() * kMaxLoad) {
+        Grow(shard);
+    }
+
+    if (use_bloom_ && !BloomTestAndSet(shard, fingerprint)) {
+        // Фильтр не ошибается в эту сторону: отпечатка в таблице нет,
+        // пробировать можно только до первого пустого слота
+        ++shard.bloom_negatives;
+        const size_t mask = shard.slots.size() - 1;
+        size_t i = fingerprint & mask;
+        while (shard.slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        shard.slots[i] = fingerprint;
+        ++shard.count;
+        return true;
+    }
+
+    ++shard.probes;
+    return TableInsert(shard, fingerprint);
+}
+
+bool SeenSet::ContainsFingerprint(uint64_t fingerprint) const {
+    fingerprint = fingerprint == 0 ? 1 : fingerprint;
+    Shard& shard = ShardFor(fingerprint);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (use_bloom_) {
+        const uint64_t bits = BloomBits(fingerprint);
+        if ((shard.bloom[(fingerprint >> 24) & (shard.bloom.size() - 1)] & bits) != bits) {
+            return false;
+        }
+    }
+
+    const size_t mask = shard.slots.size() - 1;
+    for (size_t i = fingerprint & mask; shard.slots[i] != 0; i = (i + 1) & mask) {
+        if (shard.slots[i] == fingerprint) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t SeenSet::Size() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->count;
+    }
+    return total;
+}
+
+void SeenSet::ForEach(const std::function<void(uint64_t)>& visit) const {
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (uint64_t fingerprint : shard->slots) {
+            if (fingerprint != 0) {
+                visit(fingerprint);
+            }
+        }
+    }
+}
+
+size_t SeenSet::MemoryBytes() const {
+    size_t total = shards_.size() * sizeof(Shard);
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += (shard->slots.capacity() + shard->bloom.capacity()) * sizeof(uint64_t);
+    }
+    return total;
+}
+
+SeenSet::Stats SeenSet::GetStats() const {
+    Stats stats;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.bloom_negatives += shard->bloom_negatives;
+        stats.probes += shard->probes;
+    }
+    return stats;
+}
\ No newline at end of file
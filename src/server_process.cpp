@@ -0,0 +1,218 @@
+#include "server_process.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::string Trim(const std::string& value) {
+    const char* spaces = " \t\r\n";
+    size_t begin = value.find_first_not_of(spaces);
+    if (begin == std::string::npos) {
+        return "";
+    }
+    return value.substr(begin, value.find_last_not_of(spaces) - begin + 1);
+}
+
+} // namespace
+
+ServerProcess::~ServerProcess() {
+    Stop();
+}
+
+bool ServerProcess::WriteConfig(const std::string& base_config, const std::string& work_dir,
+    const std::string& section, const std::map<std::string, std::string>& overrides, std::string& error) {
+    std::ifstream in(base_config);
+    if (!in.is_open()) {
+        error = "Cannot read " + base_config;
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(work_dir, ec);
+
+    std::vector<std::string> lines;
+    std::map<std::string, std::string> pending = overrides;
+    std::string current;
+    bool seen_section = false;
+
+    auto flush_pending = [&]() {
+        for (const auto& [key, value] : pending) {
+            lines.push_back(key + "=" + value);
+        }
+        pending.clear();
+    };
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string trimmed = Trim(line);
+        if (!trimmed.empty() && trimmed.front() == '[' && trimmed.back() == ']') {
+            if (current == section) {
+                flush_pending();
+            }
+            current = trimmed.substr(1, trimmed.size() - 2);
+            seen_section = seen_section || current == section;
+        }
+        else if (current == section) {
+            size_t eq = trimmed.find('=');
+            if (eq != std::string::npos) {
+                auto it = pending.find(Trim(trimmed.substr(0, eq)));
+                if (it != pending.end()) {
+                    line = it->first + "=" + it->second;
+                    pending.erase(it);
+                }
+                else if (overrides.count(Trim(trimmed.substr(0, eq)))) {
+                    // Повтор уже замененного ключа перекрыл бы замену
+                    continue;
+                }
+            }
+        }
+        lines.push_back(line);
+    }
+    if (current == section) {
+        flush_pending();
+    }
+    if (!seen_section) {
+        lines.push_back("[" + section + "]");
+        flush_pending();
+    }
+
+    std::ofstream out(work_dir + "/config.ini", std::ios::trunc);
+    for (const auto& output_line : lines) {
+        out << output_line << "\n";
+    }
+    out.close();
+    if (out.fail()) {
+        error = "Cannot write " + work_dir + "/config.ini";
+        return false;
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool ServerProcess::Start(const std::string& executable, const std::string& work_dir, std::string& error) {
+    const std::string path = std::filesystem::absolute(executable).string();
+    const std::string log_path = work_dir + "\\server.log";
+
+    SECURITY_ATTRIBUTES inherit{ sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+    HANDLE log = CreateFileA(log_path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &inherit,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    STARTUPINFOA startup{};
+    startup.cb = sizeof(startup);
+    if (log != INVALID_HANDLE_VALUE) {
+        startup.dwFlags = STARTF_USESTDHANDLES;
+        startup.hStdOutput = log;
+        startup.hStdError = log;
+        startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+    }
+
+    PROCESS_INFORMATION info{};
+    std::string command_line = "\"" + path + "\"";
+    BOOL created = CreateProcessA(path.c_str(), &command_line[0], nullptr, nullptr, TRUE,
+        CREATE_NO_WINDOW, nullptr, work_dir.c_str(), &startup, &info);
+    if (log != INVALID_HANDLE_VALUE) {
+        CloseHandle(log);
+    }
+    if (!created) {
+        error = "Cannot start " + path + " (error " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+
+    CloseHandle(info.hThread);
+    process_ = info.hProcess;
+    return true;
+}
+
+bool ServerProcess::Running() {
+    return process_ && WaitForSingleObject(process_, 0) == WAIT_TIMEOUT;
+}
+
+void ServerProcess::Stop() {
+    if (!process_) {
+        return;
+    }
+    // Консольного Ctrl+C другому процессу без общей консоли не послать
+    TerminateProcess(process_, 1);
+    WaitForSingleObject(process_, 5000);
+    CloseHandle(process_);
+    process_ = nullptr;
+}
+
+#else
+
+bool ServerProcess::Start(const std::string& executable, const std::string& work_dir, std::string& error) {
+    // Путь к серверу считается до смены каталога в дочернем процессе
+    const std::string path = std::filesystem::absolute(executable).string();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        error = "Cannot fork";
+        return false;
+    }
+
+    if (pid == 0) {
+        if (chdir(work_dir.c_str()) != 0) {
+            _exit(127);
+        }
+        int log = open("server.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0) {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+        execl(path.c_str(), path.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    pid_ = pid;
+    return true;
+}
+
+bool ServerProcess::Running() {
+    if (pid_ <= 0) {
+        return false;
+    }
+    int status = 0;
+    if (waitpid(pid_, &status, WNOHANG) == pid_) {
+        pid_ = -1;
+        return false;
+    }
+    return true;
+}
+
+void ServerProcess::Stop() {
+    if (pid_ <= 0) {
+        return;
+    }
+
+    kill(pid_, SIGTERM);
+    for (int i = 0; i < 30; ++i) {
+        int status = 0;
+        if (waitpid(pid_, &status, WNOHANG) == pid_) {
+            pid_ = -1;
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    kill(pid_, SIGKILL);
+    int status = 0;
+    waitpid(pid_, &status, 0);
+    pid_ = -1;
+}
+
+#endif
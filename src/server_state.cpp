@@ -0,0 +1,22 @@
+#include "server_state.h"
+#include <algorithm>
+#include <atomic>
+
+void ServingState::ApplyConfig(const Config& config) {
+    max_results = config.GetMaxResults();
+    // Верхняя граница std::clamp(limit, 1, api_max_limit) не может быть меньше нижней
+    api_max_limit = std::max(config.GetApiMaxLimit(), 1);
+    compression_enabled = config.GetCompressionEnabled();
+    compression_level = config.GetCompressionLevel();
+    compression_min_size = config.GetCompressionMinSize();
+    cache_control = config.GetCacheControl();
+    search_timeout_ms = config.GetSearchTimeoutMs();
+}
+
+std::shared_ptr<const ServingState> ServingStateHolder::Load() const {
+    return std::atomic_load(&state_);
+}
+
+void ServingStateHolder::Store(std::shared_ptr<const ServingState> state) {
+    std::atomic_store(&state_, std::move(state));
+}
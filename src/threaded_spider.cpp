@@ -2,11 +2,42 @@
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <algorithm>
+
+namespace {
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+Frontier::Options MakeFrontierOptions(const Config& config) {
+    Frontier::Options options;
+    options.default_delay = std::chrono::milliseconds(std::max(config.GetDelayBetweenRequests(), 0));
+    options.fetch_robots = config.GetRespectCrawlDelay();
+    options.memory_urls = static_cast<size_t>(std::max(config.GetFrontierMemoryUrls(), 2));
+    options.segment_urls = static_cast<size_t>(std::max(config.GetFrontierSegmentUrls(), 1));
+    options.spill_dir = config.GetFrontierDir();
+    return options;
+}
+
+} // namespace
 
 ThreadedSpider::ThreadedSpider(Config& config, Database& db)
-    : config_(config), db_(db) {
-    http_client_.SetTimeout(config_.GetRequestTimeout());
-    http_client_.SetUserAgent(config_.GetUserAgent());
+    : config_(config), db_(db), http_context_(std::make_shared<HttpClientContext>()),
+    frontier_(MakeFrontierOptions(config)),
+    seen_urls_(static_cast<size_t>(std::max(config.GetSeenExpectedUrls(), 1)), config.GetSeenBloom()) {
+    http_context_->GetDnsCache().SetTtl(std::chrono::seconds(config_.GetDnsTtl()),
+        std::chrono::seconds(config_.GetDnsNegativeTtl()));
+    for (int i = 0; i < std::max(config_.GetFetchThreads(), 1); ++i) {
+        auto fetcher = std::make_unique<Fetcher>(http_context_);
+        fetcher->client.SetTimeout(config_.GetRequestTimeout());
+        fetcher->client.SetUserAgent(config_.GetUserAgent());
+        fetcher->client.SetPoolLimits(config_.GetPoolMaxIdlePerHost(), config_.GetPoolIdleTimeout());
+        fetcher->client.SetMaxDecompressedSize(static_cast<size_t>(std::max(config_.GetMaxDecompressedSize(), 0)));
+        fetcher->client.SetMaxBodySize(static_cast<size_t>(std::max(config_.GetMaxPageSize(), 0)));
+        fetchers_.push_back(std::move(fetcher));
+    }
+    RegisterMetrics();
 
     std::cout << "ThreadedSpider initialized with:" << std::endl;
     std::cout << "  Start URL: " << config_.GetStartUrl() << std::endl;
@@ -15,6 +46,155 @@ ThreadedSpider::ThreadedSpider(Config& config, Database& db)
     std::cout << "  Timeout: " << config_.GetRequestTimeout() << "s" << std::endl;
 }
 
+void ThreadedSpider::RegisterMetrics() {
+    auto& metrics = Metrics::Instance();
+    metric_ids_.fetch_seconds = metrics.RegisterHistogram("spider_fetch_seconds",
+        "Time to download a page", Metrics::LatencyBuckets());
+    metric_ids_.fetch_bytes = metrics.RegisterHistogram("spider_fetch_bytes",
+        "Size of downloaded page bodies", Metrics::SizeBuckets());
+    metric_ids_.fetched_bytes_total = metrics.RegisterCounter("spider_fetched_bytes_total",
+        "Total bytes of downloaded page bodies");
+    metric_ids_.transferred_bytes_total = metrics.RegisterCounter("spider_transferred_bytes_total",
+        "Total bytes of page bodies as received, before gzip/deflate decoding");
+    metric_ids_.parse_seconds = metrics.RegisterHistogram("spider_parse_seconds",
+        "Time to extract text, words and title from a page", Metrics::LatencyBuckets());
+    metric_ids_.index_seconds = metrics.RegisterHistogram("spider_index_seconds",
+        "Time to store a page and its words in the database", Metrics::LatencyBuckets());
+    metric_ids_.pages_indexed = metrics.RegisterCounter("spider_pages_total",
+        "Pages processed, by result", "result=\"indexed\"");
+    metric_ids_.pages_failed = metrics.RegisterCounter("spider_pages_total",
+        "Pages processed, by result", "result=\"failed\"");
+    metric_ids_.pages_skipped = metrics.RegisterCounter("spider_pages_total",
+        "Pages processed, by result", "result=\"skipped\"");
+    metric_ids_.pages_not_modified = metrics.RegisterCounter("spider_pages_total",
+        "Pages processed, by result", "result=\"not_modified\"");
+    metric_ids_.queue_size = metrics.RegisterGauge("spider_queue_size",
+        "URLs waiting in the crawl queue");
+    metric_ids_.queue_spilled = metrics.RegisterGauge("spider_queue_spilled_urls",
+        "URLs of the crawl queue kept in on-disk segments instead of memory");
+    metric_ids_.fetches_in_flight = metrics.RegisterGauge("spider_fetches_in_flight",
+        "Pages being downloaded or waiting to be parsed");
+    metric_ids_.pool_hits = metrics.RegisterCounter("spider_connection_pool_requests_total",
+        "Requests by whether they reused a keep-alive connection", "result=\"hit\"");
+    metric_ids_.pool_misses = metrics.RegisterCounter("spider_connection_pool_requests_total",
+        "Requests by whether they reused a keep-alive connection", "result=\"miss\"");
+    metric_ids_.setup_saved_ms = metrics.RegisterCounter("spider_connection_setup_saved_milliseconds_total",
+        "Estimated connect and TLS handshake time saved by connection reuse");
+    metric_ids_.tls_full = metrics.RegisterCounter("spider_tls_handshakes_total",
+        "TLS handshakes by whether a cached session was resumed", "session=\"new\"");
+    metric_ids_.tls_resumed = metrics.RegisterCounter("spider_tls_handshakes_total",
+        "TLS handshakes by whether a cached session was resumed", "session=\"resumed\"");
+    metric_ids_.dns_hits = metrics.RegisterCounter("spider_dns_lookups_total",
+        "Host name lookups by how the DNS cache answered them", "result=\"hit\"");
+    metric_ids_.dns_negative_hits = metrics.RegisterCounter("spider_dns_lookups_total",
+        "Host name lookups by how the DNS cache answered them", "result=\"negative_hit\"");
+    metric_ids_.dns_misses = metrics.RegisterCounter("spider_dns_lookups_total",
+        "Host name lookups by how the DNS cache answered them", "result=\"miss\"");
+    metric_ids_.dns_coalesced = metrics.RegisterCounter("spider_dns_lookups_total",
+        "Host name lookups by how the DNS cache answered them", "result=\"coalesced\"");
+}
+
+HttpClient::PoolStats ThreadedSpider::CollectPoolStats() const {
+    HttpClient::PoolStats total;
+    for (const auto& fetcher : fetchers_) {
+        auto stats = fetcher->client.GetPoolStats();
+        total.hits += stats.hits;
+        total.misses += stats.misses;
+        total.setup_seconds += stats.setup_seconds;
+        total.saved_seconds += stats.saved_seconds;
+    }
+    return total;
+}
+
+void ThreadedSpider::ReportClientStats() {
+    auto stats = CollectPoolStats();
+    auto& metrics = Metrics::Instance();
+    metrics.Increment(metric_ids_.pool_hits, stats.hits - reported_pool_stats_.hits);
+    metrics.Increment(metric_ids_.pool_misses, stats.misses - reported_pool_stats_.misses);
+    metrics.Increment(metric_ids_.setup_saved_ms, static_cast<uint64_t>(stats.saved_seconds * 1000) -
+        static_cast<uint64_t>(reported_pool_stats_.saved_seconds * 1000));
+    reported_pool_stats_ = stats;
+
+    auto tls = http_context_->GetTlsStats();
+    metrics.Increment(metric_ids_.tls_full,
+        (tls.handshakes - tls.resumed) - (reported_tls_stats_.handshakes - reported_tls_stats_.resumed));
+    metrics.Increment(metric_ids_.tls_resumed, tls.resumed - reported_tls_stats_.resumed);
+    reported_tls_stats_ = tls;
+
+    auto dns = http_context_->GetDnsCache().GetStats();
+    metrics.Increment(metric_ids_.dns_hits, dns.hits - reported_dns_stats_.hits);
+    metrics.Increment(metric_ids_.dns_negative_hits, dns.negative_hits - reported_dns_stats_.negative_hits);
+    metrics.Increment(metric_ids_.dns_misses, dns.misses - reported_dns_stats_.misses);
+    metrics.Increment(metric_ids_.dns_coalesced, dns.coalesced - reported_dns_stats_.coalesced);
+    reported_dns_stats_ = dns;
+}
+
+void ThreadedSpider::CheckpointThread() {
+    const auto interval = std::chrono::seconds(std::max(config_.GetCheckpointInterval(), 1));
+    auto next_checkpoint = std::chrono::steady_clock::now() + interval;
+
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() < next_checkpoint) {
+            continue;
+        }
+        WriteCheckpoint();
+        next_checkpoint = std::chrono::steady_clock::now() + interval;
+    }
+}
+
+void ThreadedSpider::WriteCheckpoint() {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::shared_mutex> lock(checkpoint_mutex_);
+
+    std::vector<UrlTask> in_flight;
+    {
+        std::lock_guard<std::mutex> tasks_lock(in_flight_tasks_mutex_);
+        for (const auto& [url, task] : in_flight_tasks_) {
+            in_flight.push_back(task);
+        }
+    }
+
+    CrawlCheckpoint::Summary summary;
+    if (CrawlCheckpoint::Save(config_.GetCheckpointFile(), seen_urls_, frontier_, in_flight, &summary)) {
+        std::cout << "Checkpoint written: " << summary.seen << " seen, " << summary.queued << " queued, "
+            << static_cast<int>(SecondsSince(start) * 1000) << "ms" << std::endl;
+    }
+}
+
+bool ThreadedSpider::ResumeFromCheckpoint() {
+    CrawlCheckpoint::Summary summary;
+    if (!CrawlCheckpoint::Load(config_.GetCheckpointFile(), seen_urls_, frontier_, &summary)) {
+        return false;
+    }
+    std::cout << "Resuming crawl: " << summary.seen << " URLs seen, " << summary.queued << " queued" << std::endl;
+    return true;
+}
+
+void ThreadedSpider::MetricsDumpThread() {
+    const auto interval = std::chrono::seconds(std::max(config_.GetMetricsDumpInterval(), 1));
+    auto next_dump = std::chrono::steady_clock::now() + interval;
+
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() < next_dump) {
+            continue;
+        }
+
+        auto frontier_stats = frontier_.GetStats();
+        Metrics::Instance().SetGauge(metric_ids_.queue_size,
+            static_cast<int64_t>(frontier_stats.memory_urls + frontier_stats.spilled_urls));
+        Metrics::Instance().SetGauge(metric_ids_.queue_spilled, static_cast<int64_t>(frontier_stats.spilled_urls));
+        ReportClientStats();
+        Metrics::Instance().DumpToFile(config_.GetMetricsFile());
+        next_dump += interval;
+    }
+
+    // Финальный снимок после остановки краулера
+    ReportClientStats();
+    Metrics::Instance().DumpToFile(config_.GetMetricsFile());
+}
+
 ThreadedSpider::~ThreadedSpider() {
     Stop();
 }
@@ -36,33 +216,87 @@ void ThreadedSpider::Start() {
     std::cout << "  Thread Count: " << config_.GetThreadCount() << std::endl;
     std::cout << "  Request Timeout: " << config_.GetRequestTimeout() << "s" << std::endl;
     std::cout << "  User Agent: " << config_.GetUserAgent() << std::endl;
-    std::cout << "  Delay between requests: " << config_.GetDelayBetweenRequests() << "ms" << std::endl;
+    std::cout << "  Delay between requests to a host: " << config_.GetDelayBetweenRequests() << "ms"
+        << (config_.GetRespectCrawlDelay() ? " (or robots.txt Crawl-delay)" : "") << std::endl;
+    std::cout << "  Max concurrent fetches: " << config_.GetMaxConcurrentFetches()
+        << " (" << fetchers_.size() << " fetch threads)" << std::endl;
+
+    if (!config_.GetMetricsFile().empty()) {
+        metrics_thread_ = std::thread(&ThreadedSpider::MetricsDumpThread, this);
+    }
+    const bool checkpoints = !config_.GetCheckpointFile().empty() && config_.GetCheckpointInterval() > 0;
 
-    //    
+    // Создаем рабочие потоки ПЕРВЫМИ
+    for (size_t i = 0; i < fetchers_.size(); ++i) {
+        fetchers_[i]->client.GetIoContext().restart();
+        fetchers_[i]->thread = std::thread(&ThreadedSpider::FetchThread, this, i);
+    }
     for (int i = 0; i < config_.GetThreadCount(); ++i) {
         workers_.emplace_back(&ThreadedSpider::WorkerThread, this);
         std::cout << "Started worker thread " << i + 1 << std::endl;
     }
 
-    //    URL  
-    AddUrlToQueue(config_.GetStartUrl(), 0);
+    // Затем продолжаем прерванный обход или добавляем начальный URL в очередь
+    if (!checkpoints || !ResumeFromCheckpoint()) {
+        AddUrlsToQueue({ config_.GetStartUrl() }, 0);
+    }
+    if (checkpoints) {
+        checkpoint_thread_ = std::thread(&ThreadedSpider::CheckpointThread, this);
+    }
+    // Если очередь пуста, диспетчер сразу завершит обход
+    for (size_t i = 0; i < fetchers_.size(); ++i) {
+        WakeFetcher(i);
+    }
 
     std::cout << "Spider started with " << workers_.size() << " worker threads" << std::endl;
 
-    //    
+    // Ждем завершения всех потоков
     for (auto& worker : workers_) {
         if (worker.joinable()) {
             worker.join();
         }
     }
+    workers_.clear();
+    for (auto& fetcher : fetchers_) {
+        if (fetcher->thread.joinable()) {
+            fetcher->thread.join();
+        }
+    }
 
     running_ = false;
 
+    if (metrics_thread_.joinable()) {
+        metrics_thread_.join();
+    }
+    if (checkpoint_thread_.joinable()) {
+        checkpoint_thread_.join();
+    }
+    if (checkpoints) {
+        // Законченному обходу точка не нужна, прерванный сохраняет последнее состояние
+        if (frontier_.Empty() && in_flight_tasks_.empty()) {
+            CrawlCheckpoint::Remove(config_.GetCheckpointFile());
+        }
+        else {
+            WriteCheckpoint();
+        }
+    }
+
     std::cout << "=== Threaded Spider Finished ===" << std::endl;
     std::cout << "Statistics:" << std::endl;
     std::cout << "  URLs Processed: " << processed_count_ << std::endl;
     std::cout << "  Errors: " << error_count_ << std::endl;
-    std::cout << "  URLs visited: " << visited_urls_.size() << std::endl;
+    std::cout << "  URLs visited: " << seen_urls_.Size() << std::endl;
+
+    auto pool_stats = CollectPoolStats();
+    std::cout << "  Connection reuse: " << static_cast<int>(pool_stats.HitRate() * 100) << "% ("
+        << pool_stats.hits << " reused, " << pool_stats.misses << " new), setup time saved ~"
+        << pool_stats.saved_seconds << "s" << std::endl;
+    auto tls_stats = http_context_->GetTlsStats();
+    std::cout << "  TLS handshakes: " << tls_stats.handshakes << " (" << tls_stats.resumed
+        << " resumed)" << std::endl;
+    auto dns_stats = http_context_->GetDnsCache().GetStats();
+    std::cout << "  DNS lookups: " << dns_stats.misses << " resolved, " << dns_stats.hits + dns_stats.negative_hits
+        << " from cache, " << dns_stats.coalesced << " coalesced" << std::endl;
 }
 
 void ThreadedSpider::Stop() {
@@ -70,23 +304,159 @@ void ThreadedSpider::Stop() {
 
     std::cout << "Stopping spider..." << std::endl;
     running_ = false;
-    queue_cv_.notify_all();
+    page_cv_.notify_all();
+    for (auto& fetcher : fetchers_) {
+        fetcher->client.GetIoContext().stop();
+    }
+}
+
+void ThreadedSpider::FetchThread(size_t index) {
+    auto& ioc = fetchers_[index]->client.GetIoContext();
+    auto work = net::make_work_guard(ioc);
+    ioc.run();
+}
+
+void ThreadedSpider::WakeFetcher(size_t index) {
+    net::post(fetchers_[index]->client.GetIoContext(), [this, index]() { DispatchFetches(index); });
+}
+
+// Загрузчик проснется к when, если не должен проснуться раньше
+void ThreadedSpider::ScheduleWake(size_t index, Frontier::Clock::time_point when) {
+    auto& fetcher = *fetchers_[index];
+    if (when >= fetcher.wake_at) {
+        return;
+    }
+    fetcher.wake_at = when;
+    fetcher.wake_timer.expires_at(when);
+    fetcher.wake_timer.async_wait([this, index](boost::beast::error_code ec) {
+        if (ec == net::error::operation_aborted) {
+            return;
+        }
+        fetchers_[index]->wake_at = Frontier::Clock::time_point::max();
+        DispatchFetches(index);
+    });
+}
+
+// Выполняется в потоке загрузчика index: берет из очереди URL хостов, к которым
+// уже можно обращаться, и начинает загрузки, пока общее их число не достигнет
+// max_concurrent_fetches. Если все хосты с работой ждут своей задержки,
+// загрузчик не спит, а ставит таймер на ближайший из них.
+void ThreadedSpider::DispatchFetches(size_t index) {
+    auto& metrics = Metrics::Instance();
+    auto& client = fetchers_[index]->client;
+    const int max_in_flight = std::max(config_.GetMaxConcurrentFetches(), 1);
+
+    while (running_) {
+        // Место резервируется до выборки из очереди: загрузчики делят общий лимит
+        int current = in_flight_.load();
+        do {
+            if (current >= max_in_flight) break;
+        } while (!in_flight_.compare_exchange_weak(current, current + 1));
+        if (current >= max_in_flight) {
+            break;
+        }
+
+        UrlTask task;
+        Frontier::Clock::time_point next_ready;
+        {
+            std::shared_lock<std::shared_mutex> lock(checkpoint_mutex_);
+            if (!frontier_.TryPop(task, next_ready)) {
+                --in_flight_;
+                if (next_ready != Frontier::Clock::time_point::max()) {
+                    ScheduleWake(index, next_ready);
+                }
+                break;
+            }
+            if (!task.robots) {
+                std::lock_guard<std::mutex> tasks_lock(in_flight_tasks_mutex_);
+                in_flight_tasks_[task.url] = task;
+            }
+        }
+
+        std::cout << "=== Fetching URL: " << task.url << " (depth: " << task.depth << ") ===" << std::endl;
+
+        auto fetch_start = std::chrono::steady_clock::now();
+        HttpClient::RequestOptions options;
+        options.validators = { task.etag, task.last_modified };
+        // robots.txt - text/plain, его тело нужно
+        options.html_only = !task.robots;
+        client.AsyncDownload(task.url, options, [this, task, fetch_start, index](HttpClient::HttpResponse response) {
+            // Отсчет задержки хоста идет от конца загрузки
+            frontier_.Complete(Frontier::HostOf(task.url));
+            if (task.robots) {
+                OnRobotsFetched(task, response);
+                FinishTask(task, index);
+                return;
+            }
+
+            auto& metrics = Metrics::Instance();
+            metrics.Observe(metric_ids_.fetch_seconds, SecondsSince(fetch_start));
+            metrics.Observe(metric_ids_.fetch_bytes, static_cast<double>(response.content.size()));
+            metrics.Increment(metric_ids_.fetched_bytes_total, response.content.size());
+            metrics.Increment(metric_ids_.transferred_bytes_total, response.transfer_size);
+
+            {
+                std::lock_guard<std::mutex> lock(page_mutex_);
+                page_queue_.push({ task, std::move(response), index });
+            }
+            page_cv_.notify_one();
+            // Хост мог освободиться сразу, если задержка нулевая
+            DispatchFetches(index);
+        });
+    }
+    metrics.SetGauge(metric_ids_.fetches_in_flight, in_flight_);
+
+    // Обход закончен: очередь пуста и ни одна страница не в работе
+    if (running_ && in_flight_ == 0 && frontier_.Empty()) {
+        std::cout << "Crawl queue is empty, stopping" << std::endl;
+        Stop();
+    }
+}
+
+void ThreadedSpider::OnRobotsFetched(const UrlTask& task, const HttpClient::HttpResponse& response) {
+    if (response.status_code != 200) {
+        return;
+    }
+
+    double crawl_delay = Frontier::ParseCrawlDelay(response.content, config_.GetUserAgent());
+    if (crawl_delay < 0) {
+        return;
+    }
+
+    // Crawl-delay только увеличивает настроенную задержку и ограничен max_crawl_delay
+    auto delay = std::chrono::milliseconds(static_cast<int64_t>(
+        std::min(crawl_delay, static_cast<double>(config_.GetMaxCrawlDelay())) * 1000));
+    delay = std::max(delay, std::chrono::milliseconds(config_.GetDelayBetweenRequests()));
+
+    const std::string host = Frontier::HostOf(task.url);
+    frontier_.SetHostDelay(host, delay);
+    std::cout << "Crawl-delay for " << host << ": " << delay.count() << "ms" << std::endl;
+}
+
+void ThreadedSpider::FinishTask(const UrlTask& task, size_t fetcher) {
+    if (!task.robots) {
+        std::shared_lock<std::shared_mutex> lock(checkpoint_mutex_);
+        std::lock_guard<std::mutex> tasks_lock(in_flight_tasks_mutex_);
+        in_flight_tasks_.erase(task.url);
+    }
+    --in_flight_;
+    WakeFetcher(fetcher);
 }
 
 void ThreadedSpider::WorkerThread() {
     std::cout << "Worker thread " << std::this_thread::get_id() << " started" << std::endl;
 
     while (running_) {
-        UrlTask task;
-        bool has_task = false;
+        FetchedPage page;
+        bool has_page = false;
 
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
+            std::unique_lock<std::mutex> lock(page_mutex_);
 
-            //     
-            if (url_queue_.empty()) {
-                queue_cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() {
-                    return !url_queue_.empty() || !running_;
+            // Ждем загруженную страницу или сигнал остановки
+            if (page_queue_.empty()) {
+                page_cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+                    return !page_queue_.empty() || !running_;
                     });
             }
 
@@ -94,83 +464,103 @@ void ThreadedSpider::WorkerThread() {
                 break;
             }
 
-            if (!url_queue_.empty()) {
-                task = url_queue_.front();
-                url_queue_.pop();
-                has_task = true;
+            if (!page_queue_.empty()) {
+                page = std::move(page_queue_.front());
+                page_queue_.pop();
+                has_page = true;
             }
         }
 
-        if (has_task) {
-            ProcessUrl(task.url, task.depth);
+        if (has_page) {
+            ProcessUrl(page.task, page.response);
+            FinishTask(page.task, page.fetcher);
         }
     }
 
     std::cout << "Worker thread " << std::this_thread::get_id() << " finished" << std::endl;
 }
 
-void ThreadedSpider::ProcessUrl(const std::string& url, int depth) {
+void ThreadedSpider::ProcessUrl(const UrlTask& task, const HttpClient::HttpResponse& response) {
     if (!running_) return;
 
-    //  
-    if (depth > config_.GetMaxDepth()) {
-        return;
-    }
-
-    //    URL  
-    {
-        std::lock_guard<std::mutex> lock(visited_mutex_);
-        if (visited_urls_.find(url) != visited_urls_.end()) {
-            return;
-        }
-        visited_urls_.insert(url);
-    }
-
+    const std::string& url = task.url;
+    const int depth = task.depth;
     std::cout << "=== Processing URL: " << url << " (depth: " << depth << ") ===" << std::endl;
 
-    //  
-    auto response = http_client_.DownloadPage(url);
+    auto& metrics = Metrics::Instance();
 
     std::cout << "Download completed - Status: " << response.status_code
         << ", Size: " << response.content.size() << " bytes" << std::endl;
 
+    if (response.status_code == 304) {
+        // Копия в индексе актуальна: разбор и индексация не нужны, обход
+        // продолжается по ссылкам, сохраненным при прошлой загрузке
+        std::cout << "Not modified since last crawl" << std::endl;
+        metrics.Increment(metric_ids_.pages_not_modified);
+        if (depth < config_.GetMaxDepth()) {
+            AddUrlsToQueue(db_.GetDocumentLinks(url), depth + 1);
+        }
+        return;
+    }
+
+    // Загрузчик оборвал тело по заголовкам: не HTML или слишком большое
+    if (!response.skip_reason.empty()) {
+        std::cout << "Skipping: " << response.skip_reason << std::endl;
+        metrics.Increment(metric_ids_.pages_skipped);
+        return;
+    }
+
     if (response.status_code != 200) {
         std::cout << "ERROR: Failed to download URL" << std::endl;
         error_count_++;
+        metrics.Increment(metric_ids_.pages_failed);
         return;
     }
 
-    // ,   HTML
-    if (response.content_type.find("text/html") == std::string::npos) {
+    // Проверяем, что это HTML
+    if (!HttpClient::IsHtml(response.content_type)) {
         std::cout << "Skipping non-HTML content" << std::endl;
+        metrics.Increment(metric_ids_.pages_skipped);
         return;
     }
 
-    //  
+    // Извлекаем текст
+    auto parse_start = std::chrono::steady_clock::now();
     std::string clean_text = HtmlParser::ExtractText(response.content);
     std::cout << "Clean text size: " << clean_text.length() << " characters" << std::endl;
 
-    //  
+    // Извлекаем слова
     auto words = HtmlParser::ExtractWords(clean_text);
     std::cout << "Extracted " << words.size() << " words" << std::endl;
 
-    //  
+    // Получаем заголовок
     std::string title = HtmlParser::GetPageTitle(response.content);
     if (title.empty()) {
         title = url;
     }
+    metrics.Observe(metric_ids_.parse_seconds, SecondsSince(parse_start));
 
-    //    
+    // Добавляем документ в базу
+    auto index_start = std::chrono::steady_clock::now();
     int doc_id = db_.AddDocument(url, title, clean_text);
     if (doc_id == -1) {
         std::cout << "ERROR: Failed to add document to database" << std::endl;
         error_count_++;
+        metrics.Increment(metric_ids_.pages_failed);
         return;
     }
 
     std::cout << "Document added with ID: " << doc_id << std::endl;
 
-    //   
+    // Запрос был условным, значит копия в базе есть и устарела: заменяем
+    // текст и старые слова, иначе частоты сложатся с прежними
+    const bool stale_copy = !task.etag.empty() || !task.last_modified.empty();
+    if (stale_copy) {
+        db_.UpdateDocument(url, title, clean_text);
+        db_.ClearDocumentWords(doc_id);
+    }
+
+    // Подсчитываем частоту слов
     std::map<std::string, int> word_freq;
     for (const auto& word : words) {
         if (word.length() >= 3 && word.length() <= 32) {
@@ -178,7 +568,7 @@ void ThreadedSpider::ProcessUrl(const std::string& url, int depth) {
         }
     }
 
-    //    
+    // Добавляем слова в базу
     int words_added = 0;
     for (const auto& [word, freq] : word_freq) {
         int word_id = db_.AddWord(word);
@@ -187,50 +577,80 @@ void ThreadedSpider::ProcessUrl(const std::string& url, int depth) {
             words_added++;
         }
     }
+    // Сервер сбрасывает ETag кэшированных результатов по смене поколения
+    db_.BumpIndexGeneration();
+    metrics.Observe(metric_ids_.index_seconds, SecondsSince(index_start));
+    metrics.Increment(metric_ids_.pages_indexed);
 
     processed_count_++;
     std::cout << "Successfully indexed page. Words added: " << words_added << std::endl;
 
-    //     
-    if (depth < config_.GetMaxDepth()) {
-        auto links = HtmlParser::ExtractLinks(response.content, url);
-        std::cout << "Found " << links.size() << " links" << std::endl;
-
-        for (const auto& link : links) {
-            AddUrlToQueue(link, depth + 1);
-        }
+    // Ссылки нужны и для следующего уровня, и для обхода после ответа 304
+    const bool has_validators = !response.etag.empty() || !response.last_modified.empty();
+    const bool store_validators = config_.GetConditionalRecrawl() && (has_validators || stale_copy);
+    std::vector<std::string> links;
+    if (depth < config_.GetMaxDepth() || store_validators) {
+        links = HtmlParser::ExtractLinks(response.content, url);
+    }
+    if (store_validators) {
+        db_.SetDocumentValidators(doc_id, response.etag, response.last_modified, links);
     }
 
-    //   
-    if (config_.GetDelayBetweenRequests() > 0) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(config_.GetDelayBetweenRequests()));
+    // Извлекаем ссылки для следующего уровня
+    if (depth < config_.GetMaxDepth()) {
+        std::cout << "Found " << links.size() << " links" << std::endl;
+        AddUrlsToQueue(links, depth + 1);
     }
 }
 
-bool ThreadedSpider::AddUrlToQueue(const std::string& url, int depth) {
+void ThreadedSpider::AddUrlsToQueue(const std::vector<std::string>& urls, int depth) {
     if (!running_ || depth > config_.GetMaxDepth()) {
-        return false;
+        return;
     }
 
-    //   URL
-    if (!http_client_.IsValidUrl(url)) {
-        return false;
+    // Проверяем валидность URL; уже встреченные отсеиваются до запроса к базе
+    std::vector<std::string> fresh;
+    for (const auto& url : urls) {
+        if (HttpClient::IsValidUrl(url) && !seen_urls_.Contains(url)) {
+            fresh.push_back(url);
+        }
+    }
+    if (fresh.empty()) {
+        return;
     }
 
-    // ,      URL
-    {
-        std::lock_guard<std::mutex> lock(visited_mutex_);
-        if (visited_urls_.find(url) != visited_urls_.end()) {
-            return false;
+    // Валидаторы сохраненных копий - одним запросом на страницу и через
+    // соединение для чтения, а не по запросу на ссылку под общей блокировкой базы
+    std::unordered_map<std::string, DocumentValidators> validators;
+    if (config_.GetConditionalRecrawl()) {
+        validators = db_.GetDocumentValidators(fresh);
+    }
+
+    for (auto& url : fresh) {
+        UrlTask task;
+        task.depth = depth;
+        auto it = validators.find(url);
+        if (it != validators.end()) {
+            task.etag = std::move(it->second.etag);
+            task.last_modified = std::move(it->second.last_modified);
         }
+        task.url = std::move(url);
+        AddUrlToQueue(std::move(task));
     }
+}
 
-    //   
+bool ThreadedSpider::AddUrlToQueue(UrlTask task) {
+    // URL отмечается посещенным при постановке в очередь: взятый из очереди
+    // URL занимает свой хост, поэтому дубликатов в ней быть не должно
     {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        url_queue_.push({ url, depth });
+        std::shared_lock<std::shared_mutex> lock(checkpoint_mutex_);
+        if (!seen_urls_.Insert(task.url)) {
+            return false;
+        }
+        frontier_.Push(std::move(task));
     }
 
-    queue_cv_.notify_one();
+    // Загрузчики будятся по очереди, чтобы новые URL расходились между ними
+    WakeFetcher(next_fetcher_++ % fetchers_.size());
     return true;
 }
\ No newline at end of file
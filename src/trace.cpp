@@ -0,0 +1,116 @@
+#include "trace.h"
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+thread_local RequestTrace* RequestTrace::current_ = nullptr;
+
+RequestTrace::RequestTrace(std::string route)
+    : previous_(current_), route_(std::move(route)), start_(std::chrono::steady_clock::now()) {
+    current_ = this;
+}
+
+RequestTrace::~RequestTrace() {
+    current_ = previous_;
+}
+
+void RequestTrace::AddSpan(const char* name, std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end) {
+    if (span_count_ >= kMaxSpans) {
+        return;
+    }
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    spans_[span_count_++] = {
+        name,
+        duration_cast<microseconds>(start - start_).count(),
+        duration_cast<microseconds>(end - start).count()
+    };
+}
+
+int64_t RequestTrace::ElapsedUs() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count();
+}
+
+SlowQueryLog& SlowQueryLog::Instance() {
+    static SlowQueryLog instance;
+    return instance;
+}
+
+void SlowQueryLog::Configure(int threshold_ms, size_t capacity, const std::string& log_file) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threshold_us_ = static_cast<int64_t>(threshold_ms) * 1000;
+    capacity_ = capacity > 0 ? capacity : 1;
+    log_file_ = log_file;
+    while (entries_.size() > capacity_) {
+        entries_.pop_front();
+    }
+}
+
+void SlowQueryLog::Record(const RequestTrace& trace) {
+    if (!Enabled()) {
+        return;
+    }
+
+    int64_t total_us = trace.ElapsedUs();
+    if (total_us < threshold_us_) {
+        return;
+    }
+
+    Entry entry;
+    entry.time = std::chrono::system_clock::now();
+    entry.route = trace.Route();
+    entry.terms = trace.Terms();
+    entry.total_us = total_us;
+    entry.spans.assign(trace.Spans(), trace.Spans() + trace.SpanCount());
+
+    std::string line = Format(entry);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (log_file_.empty()) {
+        std::cerr << line << std::endl;
+    }
+    else {
+        std::ofstream file(log_file_, std::ios::app);
+        file << line << "\n";
+    }
+
+    entries_.push_back(std::move(entry));
+    if (entries_.size() > capacity_) {
+        entries_.pop_front();
+    }
+}
+
+std::vector<SlowQueryLog::Entry> SlowQueryLog::Recent(size_t count) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = std::min(count, entries_.size());
+    return std::vector<Entry>(entries_.end() - static_cast<std::ptrdiff_t>(n), entries_.end());
+}
+
+std::string SlowQueryLog::Format(const Entry& entry) {
+    std::time_t time = std::chrono::system_clock::to_time_t(entry.time);
+    std::tm tm_time{};
+#ifdef _WIN32
+    localtime_s(&tm_time, &time);
+#else
+    localtime_r(&time, &tm_time);
+#endif
+
+    std::ostringstream out;
+    out << "Slow query " << std::put_time(&tm_time, "%Y-%m-%d %H:%M:%S")
+        << " route=" << entry.route
+        << " total=" << entry.total_us / 1000.0 << "ms terms=[";
+    for (size_t i = 0; i < entry.terms.size(); ++i) {
+        if (i > 0) out << ",";
+        out << entry.terms[i];
+    }
+    out << "]";
+    for (const auto& span : entry.spans) {
+        out << " " << span.name << "=" << span.duration_us / 1000.0 << "ms@" << span.start_us / 1000.0;
+    }
+    return out.str();
+}